@@ -0,0 +1,135 @@
+// Per message type latency of building books from an ITCH file
+// every message the books handle is timed with the TSC and recorded in a histogram for its type,
+// results go to stdout and, one row per type, to a CSV for comparing runs
+// usage: ./book-bench itch_filename [results.csv]
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "itch_dispatcher.hpp"
+#include "book_set.hpp"
+#include "latency_histogram.hpp"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <cstdlib>
+#include <x86intrin.h>              // rdtsc
+
+// TSC reads ordered against the timed code
+static inline uint64_t startTimer() {
+    _mm_lfence();
+    return __rdtsc();
+}
+static inline uint64_t stopTimer() {
+    unsigned aux;
+    uint64_t const t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+
+// Forwards each message Inner handles to it, timing the call into a histogram per type
+template <typename Inner>
+class Timed {
+public:
+    explicit Timed(Inner & _inner) : inner(_inner) {}
+
+    template <typename Message>
+        requires ITCH::HandlesMessage<Inner, Message>
+    void onMessage(Message const & message) {
+        uint64_t const t1 = startTimer();
+        inner.onMessage(message);
+        uint64_t const t2 = stopTimer();
+        histograms[static_cast<uint8_t>(message.messageType())].record(t2 - t1);
+    }
+
+    LatencyHistogram const & histogram(ITCH::MessageType_t type) const { return histograms[static_cast<uint8_t>(type)]; }
+
+private:
+    Inner &             inner;
+    LatencyHistogram    histograms[256];
+};
+
+struct TypeName {
+    ITCH::MessageType_t type;
+    char const *        tag;
+};
+
+static constexpr TypeName bookTypes[] = {
+    {ITCH::AddOrderMessageType,                 ITCH::TypeTag<ITCH::AddOrderMessageType>},
+    {ITCH::AddOrderMPIDAttributionMessageType,  ITCH::TypeTag<ITCH::AddOrderMPIDAttributionMessageType>},
+    {ITCH::OrderExecutedMessageType,            ITCH::TypeTag<ITCH::OrderExecutedMessageType>},
+    {ITCH::OrderExecutedWithPriceMessageType,   ITCH::TypeTag<ITCH::OrderExecutedWithPriceMessageType>},
+    {ITCH::OrderCancelMessageType,              ITCH::TypeTag<ITCH::OrderCancelMessageType>},
+    {ITCH::OrderDeleteMessageType,              ITCH::TypeTag<ITCH::OrderDeleteMessageType>},
+    {ITCH::OrderReplaceMessageType,             ITCH::TypeTag<ITCH::OrderReplaceMessageType>},
+};
+
+// cost of the timer pair itself, included in every sample
+static uint64_t timerOverhead() {
+    LatencyHistogram h;
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t const t1 = startTimer();
+        uint64_t const t2 = stopTimer();
+        h.record(t2 - t1);
+    }
+    return h.percentile(0.5);
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " itch_filename [results.csv]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ITCH::MappedReader reader(argv[1]);
+    BookSet books;
+    Timed<BookSet> timed(books);
+
+    uint64_t messages = 0;
+    auto const wall1 = std::chrono::steady_clock::now();
+    uint64_t const tsc1 = __rdtsc();
+    char const * messageData;
+    while ((messageData = reader.nextMessage())) {
+        ITCH::Dispatcher<Timed<BookSet>>::dispatch(timed, messageData);
+        ++messages;
+    }
+    uint64_t const tsc2 = __rdtsc();
+    auto const wall2 = std::chrono::steady_clock::now();
+
+    double const elapsedNs = std::chrono::duration<double, std::nano>(wall2 - wall1).count();
+    double const nsPerCycle = elapsedNs / (tsc2 - tsc1);
+    uint64_t const overhead = timerOverhead();
+
+    std::cout << "file " << argv[1] << std::endl;
+    std::cout << "levels " << (LEVEL_LADDER ? "ladder" : "tree") << ", orders " << (FLAT_ORDER_INDEX ? "flat" : "hash") << std::endl;
+    std::cout << messages << " messages in " << elapsedNs / 1e6 << " ms, " << elapsedNs / messages << " ns/message" << std::endl;
+    std::cout << "TSC " << 1 / nsPerCycle << " GHz, timer overhead " << overhead << " cycles (included below)" << std::endl;
+    std::cout << std::left << std::setw(6) << "type" << std::right
+        << std::setw(12) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << "  (ns)" << std::endl;
+
+    std::ofstream csv;
+    if (argc > 2) {
+        csv.open(argv[2]);
+        csv << "type,tag,count,mean_ns,p50_ns,p99_ns,p999_ns,max_ns" << std::endl;
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    csv << std::fixed << std::setprecision(1);
+    for (TypeName const & t : bookTypes) {
+        LatencyHistogram const & h = timed.histogram(t.type);
+        double const values[] = {
+            h.mean() * nsPerCycle,
+            h.percentile(0.5) * nsPerCycle,
+            h.percentile(0.99) * nsPerCycle,
+            h.percentile(0.999) * nsPerCycle,
+            h.max() * nsPerCycle,
+        };
+        std::cout << std::left << std::setw(6) << t.tag << std::right << std::setw(12) << h.count();
+        for (size_t i = 0; i < 4; ++i) std::cout << std::setw(10) << values[i];
+        std::cout << std::setw(12) << values[4] << std::endl;
+        if (csv.is_open()) {
+            csv << t.type << "," << t.tag << "," << h.count();
+            for (double v : values) csv << "," << v;
+            csv << std::endl;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+// Framing microbenchmark: per message reader loop against the bulk Framer
+// both pick out the messages that reach a book (A/F/E/C/X/D/U), after checking that the scalar and AVX2
+// paths pick the same messages as the reader
+// usage: ./framer-bench itch_filename [window_messages, default 1024]
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "itch_framer.hpp"
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <fcntl.h>                  // open
+#include <unistd.h>                 // close
+#include <sys/mman.h>               // mmap
+#include <sys/stat.h>               // fstat
+
+static ITCH::TypeSet const bookTypes{
+    ITCH::AddOrderMessageType,
+    ITCH::AddOrderMPIDAttributionMessageType,
+    ITCH::OrderExecutedMessageType,
+    ITCH::OrderExecutedWithPriceMessageType,
+    ITCH::OrderCancelMessageType,
+    ITCH::OrderDeleteMessageType,
+    ITCH::OrderReplaceMessageType
+};
+
+struct Result {
+    size_t messages;
+    size_t selected;
+    double nanoseconds;
+};
+
+static void report(char const * name, Result const & r) {
+    std::cout << name << ": " << r.messages << " messages, " << r.selected << " selected, "
+        << r.nanoseconds / r.messages << " ns/message" << std::endl;
+}
+
+static Result perMessage(char const * filename) {
+    ITCH::MappedReader reader(filename);
+    Result r{0, 0, 0};
+    auto const t1 = std::chrono::steady_clock::now();
+    char const * messageData;
+    while ((messageData = reader.nextMessage())) {
+        ++r.messages;
+        r.selected += bookTypes.contains(ITCH::Parser::getDataMessageType(messageData));
+    }
+    r.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t1).count();
+    return r;
+}
+
+// scalar and AVX2 framers in lockstep over the mapping, against the reader's messages
+static bool check(char const * filename, char const * begin, char const * end, size_t window) {
+    ITCH::MappedReader reader(filename);
+    ITCH::Framer scalar(window, false);
+    ITCH::Framer avx2(window, true);
+    std::vector<uint32_t> scalarIndices;
+    std::vector<uint32_t> avx2Indices;
+    std::vector<uint32_t> readerIndices;
+    uint64_t windows = 0;
+    while (begin < end) {
+        size_t const framed = scalar.frame(begin, end);
+        if (avx2.frame(begin, end) != framed || avx2.size() != scalar.size() || avx2.endOfSession() != scalar.endOfSession()) {
+            std::cout << "window " << windows << ": framed differently" << std::endl;
+            return false;
+        }
+        if (!framed) break;
+        scalar.gatherTypes();
+        avx2.gatherTypes();
+        readerIndices.clear();
+        for (size_t i = 0; i < scalar.size(); ++i) {
+            char const * const messageData = reader.nextMessage();
+            if (messageData == nullptr || ITCH::Parser::getDataMessageType(messageData) != scalar.type(i) || avx2.type(i) != scalar.type(i)) {
+                std::cout << "window " << windows << ", message " << i << ": type differs from the reader's" << std::endl;
+                return false;
+            }
+            if (bookTypes.contains(scalar.type(i))) readerIndices.push_back(i);
+        }
+        scalar.select(bookTypes, scalarIndices);
+        avx2.select(bookTypes, avx2Indices);
+        if (scalarIndices != readerIndices || avx2Indices != readerIndices) {
+            std::cout << "window " << windows << ": selected indices differ (reader " << readerIndices.size()
+                << ", scalar " << scalarIndices.size() << ", avx2 " << avx2Indices.size() << ")" << std::endl;
+            return false;
+        }
+        begin += framed;
+        ++windows;
+        if (scalar.endOfSession()) break;
+    }
+    if (reader.nextMessage()) {
+        std::cout << "window " << windows << ": the reader has messages past the framed ones" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static Result bulk(char const * begin, char const * end, size_t window, bool avx2) {
+    ITCH::Framer framer(window, avx2);
+    std::vector<uint32_t> indices;
+    Result r{0, 0, 0};
+    auto const t1 = std::chrono::steady_clock::now();
+    while (begin < end) {
+        size_t const framed = framer.frame(begin, end);
+        if (!framed) break;
+        framer.gatherTypes();
+        r.messages += framer.size();
+        r.selected += framer.select(bookTypes, indices);
+        begin += framed;
+        if (framer.endOfSession()) break;
+    }
+    r.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t1).count();
+    return r;
+}
+
+int main(int argc, char ** argv) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " itch_filename [window_messages]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    size_t const window = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1 << 10;
+
+    int const fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st)) {
+        std::cout << "cannot open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    void * const mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cout << "cannot map " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    char const * const begin = static_cast<char const *>(mapping);
+    char const * const end = begin + st.st_size;
+
+    std::cout << "window " << window << " messages, AVX2 " << (ITCH::Framer::hasAVX2() ? "available" : "unavailable") << std::endl;
+    bool checked;
+    try {
+        checked = check(argv[1], begin, end, window);
+    } catch (std::exception const & e) {
+        std::cout << e.what() << std::endl;
+        checked = false;
+    }
+    if (!checked) {
+        munmap(mapping, st.st_size);
+        return EXIT_FAILURE;
+    }
+    // first pass warms the page cache for every run after it
+    perMessage(argv[1]);
+    report("per message", perMessage(argv[1]));
+    report("bulk scalar", bulk(begin, end, window, false));
+    report("bulk avx2  ", bulk(begin, end, window, true));
+
+    munmap(mapping, st.st_size);
+}
@@ -0,0 +1,62 @@
+#ifndef ORDER_BOOK_LATENCY_HISTOGRAM_HPP
+#define ORDER_BOOK_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// HDR style log-linear histogram of non negative integer samples (e.g. TSC cycles)
+// every power of two range is split into SUB_BUCKETS / 2 linear buckets,
+// so any recorded value is reported within 1 / (SUB_BUCKETS / 2) (~6%) of itself
+// recording is an index computation and an increment, fixed memory regardless of range
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS      = 5;
+    static constexpr uint64_t SUB_BUCKETS   = 1 << SUB_BITS;
+    static constexpr uint64_t HALF          = SUB_BUCKETS / 2;
+    static constexpr size_t   BUCKETS       = SUB_BUCKETS + (64 - SUB_BITS) * HALF;
+
+    void record(uint64_t value) {
+        ++counts[indexOf(value)];
+        ++total;
+        sum += value;
+        largest = std::max(largest, value);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+    double mean() const { return total ? double(sum) / total : 0; }
+
+    // highest value equivalent to the sample at quantile q (0-1), max() for q == 1
+    uint64_t percentile(double q) const {
+        if (!total) return 0;
+        uint64_t const rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * total + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(highestEquivalent(i), largest);
+        }
+        return largest;
+    }
+
+private:
+    // values below SUB_BUCKETS are exact, above they keep their top SUB_BITS bits
+    static size_t indexOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return value;
+        unsigned const shift = 63 - __builtin_clzll(value) - (SUB_BITS - 1);
+        return SUB_BUCKETS + (shift - 1) * HALF + ((value >> shift) - HALF);
+    }
+    static uint64_t highestEquivalent(size_t index) {
+        if (index < SUB_BUCKETS) return index;
+        unsigned const shift = (index - SUB_BUCKETS) / HALF + 1;
+        uint64_t const top = (index - SUB_BUCKETS) % HALF + HALF;
+        return ((top + 1) << shift) - 1;
+    }
+
+    uint64_t counts[BUCKETS]    = {};
+    uint64_t total              = 0;
+    uint64_t sum                = 0;
+    uint64_t largest            = 0;
+};
+
+#endif // ORDER_BOOK_LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,53 @@
+#ifndef ORDER_BOOK_BBO_TAPE_HPP
+#define ORDER_BOOK_BBO_TAPE_HPP
+
+#include "order_book.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// One conflated top of book, 32 bytes in host byte order
+struct BboRecord {
+    uint64_t    timestamp   : 48;
+    uint64_t    stockLocate : 16;
+    Quote       bid;
+    Quote       ask;
+};
+
+static_assert(sizeof(BboRecord) == 32, "BboRecord must stay at two per cache line");
+
+// Binary BBO tape written by one BookSet
+// a book's BBO is written at most once per conflation window, and only if it differs from the last one written
+class BboTape {
+public:
+    enum class Conflation {
+        TIMESTAMP,  // window closes when the timestamp moves on
+        BATCH,      // window closes after each handleBatch/handleMessage call
+    };
+
+    BboTape(char const * filename, Conflation);
+    ~BboTape();
+
+    BboTape(BboTape const &)                = delete;
+    BboTape & operator=(BboTape const &)    = delete;
+
+    void write(BboRecord const & record) {
+        buffer.push_back(record);
+        if (buffer.size() == BUFFER_RECORDS) flush();
+    }
+    void flush();
+
+    Conflation conflation() const { return mode; }
+    uint64_t records() const { return written + buffer.size(); }
+
+private:
+    static constexpr size_t BUFFER_RECORDS = 1 << 15;
+
+    FILE *                  out;
+    Conflation const        mode;
+    std::vector<BboRecord>  buffer;
+    uint64_t                written;
+};
+
+#endif // ORDER_BOOK_BBO_TAPE_HPP
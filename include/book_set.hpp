@@ -0,0 +1,108 @@
+#ifndef ORDER_BOOK_BOOK_SET_HPP
+#define ORDER_BOOK_BOOK_SET_HPP
+
+#include "order_book.hpp"
+#include "depth_feed.hpp"
+#include "bbo_tape.hpp"
+#include "trade_tape.hpp"
+#include "snapshot.hpp"
+#include <bitset>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <boost/pool/object_pool.hpp>
+
+// outputs of a BookSet's books, each has a single producer so every BookSet needs its own
+struct BookFeeds {
+    DepthFeed * depth   = nullptr;  // top N level changes, see OrderBook
+    BboTape *   bbo     = nullptr;  // conflated BBO changes
+    TradeTape * trades  = nullptr;  // printable executions, bars and broken trades
+};
+
+// Order books keyed by stock locate, fed raw message data
+// a flat table of every locate, books are created by the stock directory (or the first add of a locate
+// it did not list) and kept for the rest of the session, one that empties is reset rather than freed
+// all books share one set of Order/Level pools, so a BookSet belongs to one thread
+class BookSet {
+public:
+    explicit BookSet(BookPools::Config const & = BookPools::Config(), BookFeeds const & = BookFeeds());
+
+    BookSet(BookSet const &)                = delete;
+    BookSet & operator=(BookSet const &)    = delete;
+
+    ~BookSet();
+
+    // with a BboTape each call is a window of Conflation::BATCH
+    void handleMessage(char const * messageData);
+    // applies count messages in order, with FLAT_ORDER_INDEX after prefetching the orders they touch
+    void handleBatch(char const * const * messages, size_t count);
+
+    // handlers for ITCH::Dispatcher, every other message type is skipped without being parsed
+    // views, so only the fields the books use are decoded
+    void onMessage(ITCH::StockDirectoryView const &);
+    void onMessage(ITCH::AddOrderView const &);
+    void onMessage(ITCH::AddOrderMPIDAttributionView const &);
+    void onMessage(ITCH::OrderExecutedView const &);
+    void onMessage(ITCH::OrderExecutedWithPriceView const &);
+    void onMessage(ITCH::OrderCancelView const &);
+    void onMessage(ITCH::OrderDeleteView const &);
+    void onMessage(ITCH::OrderReplaceView const &);
+    // only with a TradeTape
+    void onMessage(ITCH::TradeView const &);
+    void onMessage(ITCH::CrossTradeView const &);
+    void onMessage(ITCH::BrokenTradeView const &);
+
+    // every non-empty book in locate order, see snapshot.hpp
+    void writeSnapshot(SnapshotWriter &) const;
+    // rebuild the books of the locates for which keep(stockLocate) is true
+    template <typename Keep>
+    void restore(SnapshotReader const & snapshot, Keep && keep) {
+        snapshot.forEachOrder(keep, [this](uint16_t stockLocate, char side, uint32_t price, uint64_t referenceNumber, uint64_t timestamp, uint32_t shares) {
+            getOrCreate(stockLocate)->restoreOrder(referenceNumber, stockLocate, timestamp, side, shares, price);
+            if (feeds.bbo) queueBbo(stockLocate);
+        });
+    }
+
+    // write the BBO of every book changed since the last window
+    void publishBbo();
+
+    // publish, then destroy every book, must run on the thread that built them
+    void clear();
+    // books created since the last clear(), empty ones included
+    size_t bookCount() const;
+    // fast path counts of every book built by this set, kept across clear()
+    PathCounters const & pathCounters() const { return pools.counters; }
+
+private:
+    void apply(char const * messageData);
+    void queueBbo(uint16_t stockLocate);
+
+    OrderBook const * peek(uint16_t stockLocate) const;
+    OrderBook * getOrCreate(uint16_t stockLocate);
+    void resetIfEmpty(OrderBook *);
+
+    BookPools pools;
+    BookFeeds feeds;
+    // locates whose BBO changed in the current window, and what was last written for each
+    std::vector<uint16_t> bboQueue;
+    std::bitset<1 << 16> bboQueued;
+    std::vector<BBO> bboWritten;
+    uint64_t lastTimestamp;
+    boost::object_pool<OrderBook> booksmem;
+    // indexed by locate, nullptr until the locate's book is created
+    std::vector<OrderBook*> books;
+    size_t created;
+
+    template <typename OStream>
+    friend OStream& operator<<(OStream&, BookSet const &);
+};
+
+template <typename OStream>
+inline OStream& operator<<(OStream& os, BookSet const & s) {
+    for (OrderBook const * book : s.books) {
+        if (book && book->orderCount()) os << *book << "\n";
+    }
+    return os;
+}
+
+#endif // ORDER_BOOK_BOOK_SET_HPP
@@ -0,0 +1,78 @@
+#ifndef ORDER_BOOK_BOOK_WORKERS_HPP
+#define ORDER_BOOK_BOOK_WORKERS_HPP
+
+#include "book_set.hpp"
+#include "symbol_filter.hpp"
+#include "spsc_ring.hpp"
+#include "message_batch.hpp"
+#include "itch_common.hpp"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// Builds books on a pool of worker threads sharded by stock locate
+// the reading thread copies each message into the ring of the worker that owns its locate
+// books of different locates never interact and a locate always maps to the same worker,
+// so per symbol message order is preserved
+class BookWorkers {
+public:
+    // the order reservation is split between the workers
+    // worker i publishes to feeds[i] if given, every feed has a single producer
+    // with a snapshot each worker first restores the books it owns, on its own thread, only subscribed ones with symbols
+    BookWorkers(size_t threads, BookPools::Config const & = BookPools::Config(), BookFeeds const * feeds = nullptr, SnapshotReader const * snapshot = nullptr, SymbolFilter const * symbols = nullptr);
+
+    BookWorkers(BookWorkers const &)                = delete;
+    BookWorkers & operator=(BookWorkers const &)    = delete;
+
+    ~BookWorkers();
+
+    void handleMessage(char const * messageData);
+    // the rings already overlap reading with building, so a batch is just handed over in order
+    void handleBatch(char const * const * messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) handleMessage(messages[i]);
+    }
+    // wait until every message handed over so far has been applied
+    void drain();
+    // drain, then every worker's books
+    void writeSnapshot(SnapshotWriter &);
+    // drain, tear down the books and join the workers
+    void finish();
+    size_t size() const { return workers.size(); }
+    // summed over the workers, once finished
+    PathCounters pathCounters() const;
+
+    static constexpr size_t RING_CAPACITY = 1 << 16;
+
+private:
+    struct Worker {
+        Worker(BookPools::Config const & config, BookFeeds const & feeds) : ring(RING_CAPACITY), books(config, feeds) {}
+        SpscRing<ITCH::MessageSlot>   ring;
+        BookSet                 books;
+        std::thread             thread;
+    };
+
+    void run(Worker &, size_t index, size_t cpu);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    SnapshotReader const * snapshot;
+    SymbolFilter const * symbols;
+    std::atomic<size_t> restoring;      // workers still restoring from snapshot
+    std::atomic<bool> done;
+
+    template <typename OStream>
+    friend OStream& operator<<(OStream&, BookWorkers &);
+};
+
+// books are only read once the workers are idle
+template <typename OStream>
+inline OStream& operator<<(OStream& os, BookWorkers & w) {
+    w.drain();
+    for (auto const & worker : w.workers) {
+        os << worker->books;
+    }
+    return os;
+}
+
+#endif // ORDER_BOOK_BOOK_WORKERS_HPP
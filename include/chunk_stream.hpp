@@ -0,0 +1,95 @@
+#ifndef ORDER_BOOK_CHUNK_STREAM_HPP
+#define ORDER_BOOK_CHUNK_STREAM_HPP
+
+#include "itch_common.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <endian.h>                 // be16toh
+
+namespace ITCH {
+
+// BinaryFILE data handed from producer threads to the reading thread in large chunks
+// chunk n is filled into slot n % slots by whichever producer owns it, and read in order
+// every slot has a pad in front of its data, a message cut off at the end of a chunk is finished
+// by copying its head (at most messageHeaderLength + maxITCHMessageSize - 1 bytes) into the next chunk's pad,
+// so messages are always contiguous and the chunks themselves are never shuffled
+// as with Reader, a message returned by nextMessage() is valid until the next call
+class ChunkStream {
+public:
+    static constexpr size_t PAD = 64;
+
+    ChunkStream(size_t slots, size_t chunkBytes);
+
+    ChunkStream(ChunkStream const &)                = delete;
+    ChunkStream & operator=(ChunkStream const &)    = delete;
+
+    // producer side
+    // the data of chunk n once the reader is done with chunk n - slots, nullptr once stopped
+    char * acquire(uint64_t n);
+    // as acquire(), but nullptr rather than waiting if the slot is still being read
+    char * tryAcquire(uint64_t n);
+    // chunk n holds bytes bytes, and is the last one if last
+    void publish(uint64_t n, size_t bytes, bool last);
+    // the reader throws this from nextMessage() once it reaches the failed chunk
+    void fail(std::string const & what);
+    // wakes producers waiting in acquire() for good
+    void stop();
+    size_t chunkBytes() const { return bytesPerChunk; }
+    size_t slotCount() const { return slots.size(); }
+
+    // reader side
+    char const * nextMessage() {
+        if (cursor + messageHeaderLength <= end) [[likely]] {
+            uint16_t const messageLength = be16toh(*(uint16_t const *)cursor);
+            if (cursor + messageHeaderLength + messageLength <= end && messageLength) [[likely]] {
+                char const * const out = cursor;
+                cursor += messageHeaderLength + messageLength;
+                bytesRead += messageHeaderLength + messageLength;
+                return out;
+            }
+        }
+        return nextChunk();
+    }
+    // skip bytes of the stream, before the first nextMessage()
+    void skip(uint64_t bytes);
+    uint64_t getBytesRead() const { return bytesRead; }
+
+private:
+    struct Slot {
+        std::vector<char>   storage;    // PAD, then the chunk
+        size_t              bytes = 0;
+        uint64_t            ready = 0;  // chunk number + 1 once published
+        bool                last  = false;
+    };
+
+    char const * nextChunk();
+    // moves on to the next chunk, carrying the unread tail of this one, false at the end of the stream
+    bool advance();
+    // waits for chunk n, throws if a producer failed first
+    Slot & wait(uint64_t n);
+
+    size_t const            bytesPerChunk;
+    std::vector<Slot>       slots;
+    std::mutex              mutex;
+    std::condition_variable changed;
+    uint64_t                released;   // chunks the reader is done with
+    bool                    stopped;
+    bool                    failed;
+    std::string             failure;
+
+    // reader state
+    uint64_t                current;    // chunk being read
+    char const *            cursor;
+    char const *            end;
+    bool                    started;
+    bool                    finished;
+    uint64_t                bytesRead;
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_CHUNK_STREAM_HPP
@@ -0,0 +1,75 @@
+#ifndef ORDER_BOOK_COMPRESSED_READER_HPP
+#define ORDER_BOOK_COMPRESSED_READER_HPP
+
+#include "itch_common.hpp"
+#include "chunk_stream.hpp"
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ITCH {
+
+// Reads BinaryFILE compressed with gzip (as NASDAQ distributes it) or zstd, without decompressing to disk first
+// the compressed file is mapped and decompressed ahead on another thread into a ChunkStream,
+// so the reading thread only frames messages out of chunks that are already there
+// zstd files of several frames with known sizes (pzstd output, the zstd seekable format) are decompressed
+// a frame per chunk on up to `decompressors` threads, gzip and other zstd files on one
+// zstd needs <zstd.h> at build time, gzip needs zlib
+class CompressedReader {
+public:
+    enum class Format { RAW, GZIP, ZSTD };
+
+    // by the magic bytes at the start of the file
+    static Format detect(char const * filename);
+
+    CompressedReader()                                          = delete;   // must provide filename
+
+    // startOffset is in the decompressed stream, the bytes before it are decompressed and skipped
+    CompressedReader(char const * _filename, uint64_t startOffset = 0, size_t decompressors = 1);
+
+    CompressedReader(const CompressedReader& p)                 = delete;
+    CompressedReader& operator=(const CompressedReader& p)      = delete;
+
+    ~CompressedReader();
+
+    char const * nextMessage() { return stream->nextMessage(); }
+    long long getTotalBytesRead() const;    // decompressed, since the start offset
+    uint64_t getOffset() const;             // decompressed stream offset of the next message
+
+    Format format() const { return fileFormat; }
+    size_t decompressorCount() const { return threads.size(); }
+
+    static constexpr size_t CHUNK_BYTES     = 4 << 20;
+    static constexpr size_t CHUNKS          = 4;            // per decompressing thread
+    static constexpr size_t MAX_FRAME_BYTES = 64 << 20;     // larger zstd frames are streamed on one thread
+
+private:
+    // a zstd frame decompressed on its own
+    struct Frame {
+        char const *    data;
+        size_t          bytes;
+        size_t          contentBytes;
+    };
+
+    void decompressStream();
+    void decompressFrames(size_t first, size_t step);
+    void findFrames();
+    // stop and join the decompressing threads, unmap the input
+    void shutdown();
+
+    std::string const               filename;
+    Format const                    fileFormat;
+    char const *                    input;
+    size_t                          inputBytes;
+    uint64_t const                  startOffset;
+    std::vector<Frame>              frames;
+    std::unique_ptr<ChunkStream>    stream;
+    std::vector<std::thread>        threads;
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_COMPRESSED_READER_HPP
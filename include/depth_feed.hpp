@@ -0,0 +1,108 @@
+#ifndef ORDER_BOOK_DEPTH_FEED_HPP
+#define ORDER_BOOK_DEPTH_FEED_HPP
+
+#include "itch_common.hpp"
+#include "spsc_ring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One change to the top N price levels of a book side (market by price, L2)
+// depth is the level's position from the touch, 0 is the best bid/offer
+// a consumer keeps each side as an array of N levels and applies updates in order:
+//   NEW     insert at depth, shifting the levels below down and dropping the one pushed past N
+//   CHANGE  set the volume at depth
+//   DELETE  remove at depth, shifting the levels below up
+// a DELETE is followed by a NEW at depth N - 1 when a level moves up into the top N
+struct DepthUpdate {
+    enum Action : uint8_t {
+        NEW     = 'N',
+        CHANGE  = 'C',
+        DELETE  = 'D',
+    };
+
+    uint16_t    stockLocate;
+    char        side;
+    uint8_t     action;
+    uint32_t    price;
+    uint32_t    volume;     // limit volume after the change, 0 for DELETE
+    uint32_t    depth;
+};
+
+static_assert(sizeof(DepthUpdate) == 16, "DepthUpdate must stay at four per cache line");
+
+// Incremental depth stream out of the books built on one thread
+// the building thread is the only producer, so each thread publishing needs its own feed
+// the books never wait on the consumer, an update that finds the ring full is dropped and counted,
+// a consumer that sees dropped() move has to rebuild from a snapshot
+class DepthFeed {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    explicit DepthFeed(size_t _levels, size_t capacity = DEFAULT_CAPACITY) :
+        topLevels(_levels), ring(capacity), droppedCount(0) {}
+
+    DepthFeed(DepthFeed const &)                = delete;
+    DepthFeed & operator=(DepthFeed const &)    = delete;
+
+    // levels per side published, changes deeper than this are not
+    size_t levels() const { return topLevels; }
+
+    // producer side
+    void publish(DepthUpdate const & update) {
+        if (!ring.push(update)) droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // consumer side
+    bool poll(DepthUpdate & update) { return ring.pop(update); }
+    bool empty() const { return ring.empty(); }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    size_t const            topLevels;
+    SpscRing<DepthUpdate>   ring;
+    std::atomic<uint64_t>   droppedCount;
+};
+
+// Consumer side L2, the top N levels of both sides of every locate rebuilt from DepthUpdates
+// i.e. what a strategy process keeps instead of running its own books
+class DepthBook {
+public:
+    struct Entry {
+        uint32_t price;
+        uint32_t volume;
+    };
+
+    explicit DepthBook(size_t _levels) : topLevels(_levels), sides(2 * (1 << 16)) {}
+
+    void apply(DepthUpdate const & u) {
+        std::vector<Entry> & levels = sides[slot(u.stockLocate, u.side)];
+        size_t const at = std::min<size_t>(u.depth, levels.size());
+        switch (u.action) {
+            case DepthUpdate::NEW:
+                levels.insert(levels.begin() + at, Entry{u.price, u.volume});
+                if (levels.size() > topLevels) levels.pop_back();
+                break;
+            case DepthUpdate::CHANGE:
+                if (at < levels.size()) levels[at].volume = u.volume;
+                break;
+            case DepthUpdate::DELETE:
+                if (at < levels.size()) levels.erase(levels.begin() + at);
+                break;
+        }
+    }
+
+    // best first, at most levels() entries
+    std::vector<Entry> const & side(uint16_t stockLocate, char side) const { return sides[slot(stockLocate, side)]; }
+    size_t levels() const { return topLevels; }
+
+private:
+    static size_t slot(uint16_t stockLocate, char side) { return 2 * size_t(stockLocate) + (side != ITCH::Side::BUY); }
+
+    size_t const                    topLevels;
+    std::vector<std::vector<Entry>> sides;
+};
+
+#endif // ORDER_BOOK_DEPTH_FEED_HPP
@@ -7,6 +7,7 @@
 namespace ITCH {
 
 constexpr size_t maxITCHMessageSize     = 50;
+constexpr size_t messageHeaderLength    = 2;    // BinaryFILE big endian length prefix
 
 namespace Side {
     constexpr char BUY  = 'B';
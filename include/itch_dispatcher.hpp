@@ -0,0 +1,134 @@
+#ifndef ORDER_BOOK_ITCH_DISPATCHER_HPP
+#define ORDER_BOOK_ITCH_DISPATCHER_HPP
+
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "itch_views.hpp"
+#include <array>
+#include <cstdint>
+
+namespace ITCH {
+
+// message type -> message struct and its parser, and the zero-copy view where there is one
+template <MessageType_t MessageType> struct MessageTraits;
+template <> struct MessageTraits<SystemEventMessageType>                { using Message = SystemEventMessage;               static constexpr auto parse = &Parser::createSystemEventMessage; using View = SystemEventView; };
+template <> struct MessageTraits<StockDirectoryMessageType>             { using Message = StockDirectoryMessage;            static constexpr auto parse = &Parser::createStockDirectoryMessage; using View = StockDirectoryView; };
+template <> struct MessageTraits<StockTradingActionMessageType>         { using Message = StockTradingActionMessage;        static constexpr auto parse = &Parser::createStockTradingActionMessage; };
+template <> struct MessageTraits<RegSHORestrictionMessageType>          { using Message = RegSHORestrictionMessage;         static constexpr auto parse = &Parser::createRegSHORestrictionMessage; };
+template <> struct MessageTraits<MarketParticipantPositionMessageType>  { using Message = MarketParticipantPositionMessage; static constexpr auto parse = &Parser::createMarketParticipantPositionMessage; };
+template <> struct MessageTraits<MWCBDeclineLevelMessageType>           { using Message = MWCBDeclineLevelMessage;          static constexpr auto parse = &Parser::createMWCBDeclineLevelMessage; };
+template <> struct MessageTraits<MWCBStatusMessageType>                 { using Message = MWCBStatusMessage;                static constexpr auto parse = &Parser::createMWCBStatusMessage; };
+template <> struct MessageTraits<IPOQuotingPeriodUpdateMessageType>     { using Message = IPOQuotingPeriodUpdateMessage;    static constexpr auto parse = &Parser::createIPOQuotingPeriodUpdateMessage; };
+template <> struct MessageTraits<LULDAuctionCollarMessageType>          { using Message = LULDAuctionCollarMessage;         static constexpr auto parse = &Parser::createLULDAuctionCollarMessage; };
+template <> struct MessageTraits<OperationalHaltMessageType>            { using Message = OperationalHaltMessage;           static constexpr auto parse = &Parser::createOperationalHaltMessage; };
+template <> struct MessageTraits<AddOrderMessageType>                   { using Message = AddOrderMessage;                  static constexpr auto parse = &Parser::createAddOrderMessage; using View = AddOrderView; };
+template <> struct MessageTraits<AddOrderMPIDAttributionMessageType>    { using Message = AddOrderMPIDAttributionMessage;   static constexpr auto parse = &Parser::createAddOrderMPIDAttributionMessage; using View = AddOrderMPIDAttributionView; };
+template <> struct MessageTraits<OrderExecutedMessageType>              { using Message = OrderExecutedMessage;             static constexpr auto parse = &Parser::createOrderExecutedMessage; using View = OrderExecutedView; };
+template <> struct MessageTraits<OrderExecutedWithPriceMessageType>     { using Message = OrderExecutedWithPriceMessage;    static constexpr auto parse = &Parser::createOrderExecutedWithPriceMessage; using View = OrderExecutedWithPriceView; };
+template <> struct MessageTraits<OrderCancelMessageType>                { using Message = OrderCancelMessage;               static constexpr auto parse = &Parser::createOrderCancelMessage; using View = OrderCancelView; };
+template <> struct MessageTraits<OrderDeleteMessageType>                { using Message = OrderDeleteMessage;               static constexpr auto parse = &Parser::createOrderDeleteMessage; using View = OrderDeleteView; };
+template <> struct MessageTraits<OrderReplaceMessageType>               { using Message = OrderReplaceMessage;              static constexpr auto parse = &Parser::createOrderReplaceMessage; using View = OrderReplaceView; };
+template <> struct MessageTraits<TradeMessageType>                      { using Message = TradeMessage;                     static constexpr auto parse = &Parser::createTradeMessage; using View = TradeView; };
+template <> struct MessageTraits<CrossTradeMessageType>                 { using Message = CrossTradeMessage;                static constexpr auto parse = &Parser::createCrossTradeMessage; using View = CrossTradeView; };
+template <> struct MessageTraits<BrokenTradeMessageType>                { using Message = BrokenTradeMessage;               static constexpr auto parse = &Parser::createBrokenTradeMessage; using View = BrokenTradeView; };
+template <> struct MessageTraits<NOIIMessageType>                       { using Message = NOIIMessage;                      static constexpr auto parse = &Parser::createNOIIMessage; };
+template <> struct MessageTraits<RetailInterestMessageType>             { using Message = RetailInterestMessage;            static constexpr auto parse = &Parser::createRetailInterestMessage; };
+template <> struct MessageTraits<DirectListingWithCapitalRaisePriceDiscoveryMessageType> { using Message = DirectListingWithCapitalRaisePriceDiscoveryMessage; static constexpr auto parse = &Parser::createDirectListingWithCapitalRaisePriceDiscoveryMessage; };
+
+template <MessageType_t... MessageTypes> struct MessageTypeList {};
+using AllMessageTypes = MessageTypeList<
+    SystemEventMessageType,
+    StockDirectoryMessageType,
+    StockTradingActionMessageType,
+    RegSHORestrictionMessageType,
+    MarketParticipantPositionMessageType,
+    MWCBDeclineLevelMessageType,
+    MWCBStatusMessageType,
+    IPOQuotingPeriodUpdateMessageType,
+    LULDAuctionCollarMessageType,
+    OperationalHaltMessageType,
+    AddOrderMessageType,
+    AddOrderMPIDAttributionMessageType,
+    OrderExecutedMessageType,
+    OrderExecutedWithPriceMessageType,
+    OrderCancelMessageType,
+    OrderDeleteMessageType,
+    OrderReplaceMessageType,
+    TradeMessageType,
+    CrossTradeMessageType,
+    BrokenTradeMessageType,
+    NOIIMessageType,
+    RetailInterestMessageType,
+    DirectListingWithCapitalRaisePriceDiscoveryMessageType
+>;
+
+// Handler has a public onMessage overload for Message
+template <typename Handler, typename Message>
+concept HandlesMessage = requires(Handler & handler, Message const & message) { handler.onMessage(message); };
+
+namespace detail {
+
+template <typename Handler>
+using DispatchEntry = void (*)(Handler &, char const *);
+
+template <typename Handler, MessageType_t MessageType>
+void decodeAndHandle(Handler & handler, char const * messageData) {
+    handler.onMessage(MessageTraits<MessageType>::parse(messageData));
+}
+
+template <typename Handler, MessageType_t MessageType>
+void viewAndHandle(Handler & handler, char const * messageData) {
+    handler.onMessage(typename MessageTraits<MessageType>::View(messageData));
+}
+
+template <typename Handler>
+void skip(Handler &, char const *) {}
+
+template <typename Handler, MessageType_t MessageType>
+constexpr bool handlesView() {
+    if constexpr (requires { typename MessageTraits<MessageType>::View; }) return HandlesMessage<Handler, typename MessageTraits<MessageType>::View>;
+    else return false;
+}
+
+// a view overload wins over a struct one, it decodes nothing up front
+template <typename Handler, MessageType_t MessageType>
+constexpr DispatchEntry<Handler> entry() {
+    if constexpr (handlesView<Handler, MessageType>()) return &viewAndHandle<Handler, MessageType>;
+    else if constexpr (HandlesMessage<Handler, typename MessageTraits<MessageType>::Message>) return &decodeAndHandle<Handler, MessageType>;
+    else return &skip<Handler>;
+}
+
+template <typename Handler, MessageType_t... MessageTypes>
+constexpr std::array<DispatchEntry<Handler>, 256> makeTable(MessageTypeList<MessageTypes...>) {
+    std::array<DispatchEntry<Handler>, 256> table{};
+    table.fill(&skip<Handler>);
+    ((table[static_cast<uint8_t>(MessageTypes)] = entry<Handler, MessageTypes>()), ...);
+    return table;
+}
+
+} // namespace detail
+
+// Routes raw message data to Handler::onMessage(T const &) through a 256 entry table built at compile time
+// T is the message's view (see itch_views.hpp) if Handler takes it, otherwise its parsed struct
+// only types Handler has an onMessage for are parsed, every other type (and unknown bytes) is a no-op
+// e.g.
+//   struct Trades { void onMessage(ITCH::TradeMessage const &); };
+//   Trades t;
+//   while ((data = reader.nextMessage())) ITCH::Dispatcher<Trades>::dispatch(t, data);
+template <typename Handler>
+class Dispatcher {
+public:
+    template <MessageType_t MessageType>
+    static constexpr bool handles = detail::handlesView<Handler, MessageType>() || HandlesMessage<Handler, typename MessageTraits<MessageType>::Message>;
+
+    static void dispatch(Handler & handler, char const * messageData) {
+        table[static_cast<uint8_t>(messageData[messageHeaderLength])](handler, messageData);
+    }
+
+private:
+    static constexpr std::array<detail::DispatchEntry<Handler>, 256> table = detail::makeTable<Handler>(AllMessageTypes{});
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_ITCH_DISPATCHER_HPP
@@ -0,0 +1,76 @@
+#ifndef ORDER_BOOK_ITCH_FRAMER_HPP
+#define ORDER_BOOK_ITCH_FRAMER_HPP
+
+#include "itch_common.hpp"
+#include <initializer_list>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ITCH {
+
+// set of message types, e.g. TypeSet{'A', 'F', 'E', 'C', 'X', 'D', 'U'}
+struct TypeSet {
+    constexpr TypeSet() : bits{} {}
+    constexpr TypeSet(std::initializer_list<MessageType_t> types) : bits{} {
+        for (MessageType_t t : types) bits[static_cast<uint8_t>(t) / 64] |= 1ULL << (static_cast<uint8_t>(t) % 64);
+    }
+    constexpr bool contains(MessageType_t t) const { return bits[static_cast<uint8_t>(t) / 64] >> (static_cast<uint8_t>(t) % 64) & 1; }
+    constexpr bool operator==(TypeSet const &) const = default;
+
+    uint64_t bits[4];
+};
+
+// Frames a window of BinaryFILE data in bulk instead of one message per call
+// frame() is the only serial pass, it follows the length prefixes and records message offsets
+// type bytes are then gathered and filtered over the dense offset array, with AVX2 where the CPU has it,
+// so later stages can pick and prefetch the messages they want without walking the stream again
+class Framer {
+public:
+    // useAVX2 is for comparing against the scalar path, it is ignored where the CPU lacks AVX2
+    explicit Framer(size_t maxMessages, bool useAVX2 = true);
+
+    // frames whole messages from the start of [begin, end), at most maxMessages of them
+    // returns the bytes framed, a message cut off by end is left for the next window
+    // stops at a 0 length prefix, see endOfSession(), and throws on a length shorter than a message header
+    size_t frame(char const * begin, char const * end);
+    // frame() reached the end of session marker, nothing after it belongs to the stream
+    bool endOfSession() const { return ended; }
+    // fills types(), must follow frame()
+    void gatherTypes();
+    // indices of framed messages whose type is in set, in stream order
+    size_t select(TypeSet const & set, std::vector<uint32_t> & indices) const;
+    // occurrences of each type byte among the framed messages
+    void countTypes(uint64_t (&counts)[256]) const;
+
+    size_t size() const { return count; }
+    // message data at i, length prefix included, as handed out by the readers
+    char const * message(size_t i) const { return base + offsets[i]; }
+    MessageType_t type(size_t i) const { return types[i]; }
+
+    static bool hasAVX2();
+
+private:
+    void gatherTypesScalar();
+    void gatherTypesAVX2();
+    size_t selectScalar(TypeSet const &, uint32_t *) const;
+    size_t selectAVX2(TypeSet const &, uint32_t *) const;
+    // the nibble tables of selectAVX2, rebuilt only when the set changes
+    void buildSelectTables(TypeSet const &) const;
+
+    size_t const                capacity;
+    bool const                  avx2;
+    char const *                base;
+    size_t                      count;
+    bool                        ended;
+    std::vector<uint32_t>       offsets;    // from base, the gather takes them as int32
+    std::vector<MessageType_t>  types;      // padded to whole vectors
+    mutable TypeSet             tableSet;
+    mutable bool                tablesBuilt;
+    alignas(16) mutable uint8_t lowHalf[16];    // high nibble 0-7
+    alignas(16) mutable uint8_t highHalf[16];   // high nibble 8-15
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_ITCH_FRAMER_HPP
@@ -13,7 +13,8 @@ public:
     Reader()                                            = delete;   // must provide filename
 
     Reader(char const * _filename);
-    Reader(char const * _filename, size_t _bufferSize);
+    // starts at startOffset, which must be the first byte of a message's length prefix
+    Reader(char const * _filename, size_t _bufferSize, uint64_t startOffset = 0);
 
     Reader(const Reader& p)                             = delete;
     Reader& operator=(const Reader& p)                  = delete;
@@ -21,15 +22,49 @@ public:
     ~Reader();
 
     char const * nextMessage();
-    long long getTotalBytesRead() const;
+    long long getTotalBytesRead() const;    // since the start offset
+    uint64_t getOffset() const;             // file offset of the next message
 
 private:
+    bool refill(size_t bytes);
+
     int const       fdItch;
     size_t const    bufferSize;
     char * const    buffer;
     char *          _buffer;
     size_t          validBytes;
     long long       totalBytesRead;
+    uint64_t const  startOffset;
+};
+
+// Maps Nasdaq BinaryFILE into memory and retrieves message data segments in place
+// returned pointers stay valid for the lifetime of the reader
+class MappedReader {
+public:
+    MappedReader()                                      = delete;   // must provide filename
+
+    // starts at startOffset, which must be the first byte of a message's length prefix
+    MappedReader(char const * _filename, uint64_t startOffset = 0);
+
+    MappedReader(const MappedReader& p)                 = delete;
+    MappedReader& operator=(const MappedReader& p)      = delete;
+
+    ~MappedReader();
+
+    char const * nextMessage();
+    long long getTotalBytesRead() const;    // since the start offset
+    uint64_t getOffset() const;             // file offset of the next message
+
+private:
+    void adviseNextWindow();
+
+    size_t          mappedBytes;
+    char const *    begin;
+    char const *    start;
+    char const *    end;
+    char const *    _cursor;
+    char const *    nextAdvise;
+    char const *    advisedEnd;
 };
 
 namespace Parser {
@@ -58,7 +93,10 @@ namespace Parser {
     DirectListingWithCapitalRaisePriceDiscoveryMessage createDirectListingWithCapitalRaisePriceDiscoveryMessage(char const *);
 
     MessageType_t getDataMessageType(char const *);
+    uint16_t getDataMessageLength(char const *);    // excluding the length prefix
+    uint16_t getDataStockLocate(char const *);
     Timestamp_t getDataTimestamp(char const *);
+    uint64_t getDataOrderReferenceNumber(char const *);    // A, F, E, C, X, D, and U's original order
     Timestamp_t strToTimestamp(char const *);
 };
 
@@ -0,0 +1,233 @@
+#ifndef ORDER_BOOK_ITCH_VIEWS_HPP
+#define ORDER_BOOK_ITCH_VIEWS_HPP
+
+#include "itch_common.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <endian.h>                 // be16toh
+
+namespace ITCH {
+
+// Zero-copy accessors over raw message data, as handed out by the readers (length prefix included)
+// nothing is decoded up front, each accessor byte swaps its own field when called
+// offsets are from the message type byte, as laid out in the ITCH 5.0 spec
+// a view is only valid while the data it points to is
+// views are distinct types per message type, so overloads on them never catch another type
+class MessageView {
+public:
+    explicit MessageView(char const * messageData) : data(messageData + messageHeaderLength) {}
+
+    static constexpr size_t MESSAGE_TYPE    = 0;
+    static constexpr size_t STOCK_LOCATE    = 1;
+    static constexpr size_t TRACKING_NUMBER = 3;
+    static constexpr size_t TIMESTAMP       = 5;    // 6 bytes
+
+    MessageType_t   messageType() const     { return data[MESSAGE_TYPE]; }
+    uint16_t        stockLocate() const     { return u16(STOCK_LOCATE); }
+    uint16_t        trackingNumber() const  { return u16(TRACKING_NUMBER); }
+    uint64_t        timestamp() const       { return uint64_t(u16(TIMESTAMP)) << 32 | u32(TIMESTAMP + 2); }
+
+protected:
+    char            c(size_t offset) const      { return data[offset]; }
+    char const *    bytes(size_t offset) const  { return data + offset; }
+    uint16_t u16(size_t offset) const { uint16_t v; std::memcpy(&v, data + offset, sizeof(v)); return be16toh(v); }
+    uint32_t u32(size_t offset) const { uint32_t v; std::memcpy(&v, data + offset, sizeof(v)); return be32toh(v); }
+    uint64_t u64(size_t offset) const { uint64_t v; std::memcpy(&v, data + offset, sizeof(v)); return be64toh(v); }
+
+    char const * data;
+};
+
+class SystemEventView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t EVENT_CODE = 11;
+
+    char eventCode() const { return c(EVENT_CODE); }
+};
+static_assert(SystemEventView::EVENT_CODE + 1 == MessageLength<SystemEventMessageType>);
+
+class StockDirectoryView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t STOCK                           = 11;   // 8 bytes, space padded
+    static constexpr size_t MARKET_CATEGORY                 = 19;
+    static constexpr size_t FINANCIAL_STATUS_INDICATOR      = 20;
+    static constexpr size_t ROUND_LOT_SIZE                  = 21;
+    static constexpr size_t ROUND_LOTS_ONLY                 = 25;
+    static constexpr size_t ISSUE_CLASSIFICATION            = 26;
+    static constexpr size_t ISSUE_SUB_TYPE                  = 27;   // 2 bytes
+    static constexpr size_t AUTHENTICITY                    = 29;
+    static constexpr size_t SHORT_SALE_THRESHOLD_INDICATOR  = 30;
+    static constexpr size_t IPO_FLAG                        = 31;
+    static constexpr size_t LULD_REFERENCE_PRICE_TIER       = 32;
+    static constexpr size_t ETP_FLAG                        = 33;
+    static constexpr size_t ETP_LEVERAGE_FACTOR             = 34;
+    static constexpr size_t INVERSE_INDICATOR               = 38;
+
+    char const *    stock() const                       { return bytes(STOCK); }
+    char            marketCategory() const              { return c(MARKET_CATEGORY); }
+    char            financialStatusIndicator() const    { return c(FINANCIAL_STATUS_INDICATOR); }
+    uint32_t        roundLotSize() const                { return u32(ROUND_LOT_SIZE); }
+    char            roundLotsOnly() const               { return c(ROUND_LOTS_ONLY); }
+    char            issueClassification() const         { return c(ISSUE_CLASSIFICATION); }
+    char const *    issueSubType() const                { return bytes(ISSUE_SUB_TYPE); }
+    char            authenticity() const                { return c(AUTHENTICITY); }
+    char            shortSaleThresholdIndicator() const { return c(SHORT_SALE_THRESHOLD_INDICATOR); }
+    char            IPOFlag() const                     { return c(IPO_FLAG); }
+    char            LULDReferencePriceTier() const      { return c(LULD_REFERENCE_PRICE_TIER); }
+    char            ETPFlag() const                     { return c(ETP_FLAG); }
+    uint32_t        ETPLeverageFactor() const           { return u32(ETP_LEVERAGE_FACTOR); }
+    char            inverseIndicator() const            { return c(INVERSE_INDICATOR); }
+};
+static_assert(StockDirectoryView::INVERSE_INDICATOR + 1 == MessageLength<StockDirectoryMessageType>);
+
+class AddOrderView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t BUY_SELL_INDICATOR      = 19;
+    static constexpr size_t SHARES                  = 20;
+    static constexpr size_t STOCK                   = 24;   // 8 bytes, space padded
+    static constexpr size_t PRICE                   = 32;
+
+    uint64_t        orderReferenceNumber() const    { return u64(ORDER_REFERENCE_NUMBER); }
+    char            buySellIndicator() const        { return c(BUY_SELL_INDICATOR); }
+    uint32_t        shares() const                  { return u32(SHARES); }
+    char const *    stock() const                   { return bytes(STOCK); }
+    uint32_t        price() const                   { return u32(PRICE); }
+};
+static_assert(AddOrderView::PRICE + 4 == MessageLength<AddOrderMessageType>);
+
+class AddOrderMPIDAttributionView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t BUY_SELL_INDICATOR      = 19;
+    static constexpr size_t SHARES                  = 20;
+    static constexpr size_t STOCK                   = 24;   // 8 bytes, space padded
+    static constexpr size_t PRICE                   = 32;
+    static constexpr size_t ATTRIBUTION             = 36;   // 4 bytes
+
+    uint64_t        orderReferenceNumber() const    { return u64(ORDER_REFERENCE_NUMBER); }
+    char            buySellIndicator() const        { return c(BUY_SELL_INDICATOR); }
+    uint32_t        shares() const                  { return u32(SHARES); }
+    char const *    stock() const                   { return bytes(STOCK); }
+    uint32_t        price() const                   { return u32(PRICE); }
+    char const *    attribution() const             { return bytes(ATTRIBUTION); }
+};
+static_assert(AddOrderMPIDAttributionView::ATTRIBUTION + 4 == MessageLength<AddOrderMPIDAttributionMessageType>);
+
+class OrderExecutedView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t EXECUTED_SHARES         = 19;
+    static constexpr size_t MATCH_NUMBER            = 23;
+
+    uint64_t orderReferenceNumber() const   { return u64(ORDER_REFERENCE_NUMBER); }
+    uint32_t executedShares() const         { return u32(EXECUTED_SHARES); }
+    uint64_t matchNumber() const            { return u64(MATCH_NUMBER); }
+};
+static_assert(OrderExecutedView::MATCH_NUMBER + 8 == MessageLength<OrderExecutedMessageType>);
+
+class OrderExecutedWithPriceView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t EXECUTED_SHARES         = 19;
+    static constexpr size_t MATCH_NUMBER            = 23;
+    static constexpr size_t PRINTABLE               = 31;
+    static constexpr size_t EXECUTION_PRICE         = 32;
+
+    uint64_t    orderReferenceNumber() const    { return u64(ORDER_REFERENCE_NUMBER); }
+    uint32_t    executedShares() const          { return u32(EXECUTED_SHARES); }
+    uint64_t    matchNumber() const             { return u64(MATCH_NUMBER); }
+    char        printable() const               { return c(PRINTABLE); }
+    uint32_t    executionPrice() const          { return u32(EXECUTION_PRICE); }
+};
+static_assert(OrderExecutedWithPriceView::EXECUTION_PRICE + 4 == MessageLength<OrderExecutedWithPriceMessageType>);
+
+class OrderCancelView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t CANCELLED_SHARES        = 19;
+
+    uint64_t orderReferenceNumber() const   { return u64(ORDER_REFERENCE_NUMBER); }
+    uint32_t cancelledShares() const        { return u32(CANCELLED_SHARES); }
+};
+static_assert(OrderCancelView::CANCELLED_SHARES + 4 == MessageLength<OrderCancelMessageType>);
+
+class OrderDeleteView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER = 11;
+
+    uint64_t orderReferenceNumber() const { return u64(ORDER_REFERENCE_NUMBER); }
+};
+static_assert(OrderDeleteView::ORDER_REFERENCE_NUMBER + 8 == MessageLength<OrderDeleteMessageType>);
+
+class OrderReplaceView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORIGINAL_ORDER_REFERENCE_NUMBER = 11;
+    static constexpr size_t NEW_ORDER_REFERENCE_NUMBER      = 19;
+    static constexpr size_t SHARES                          = 27;
+    static constexpr size_t PRICE                           = 31;
+
+    uint64_t originalOrderReferenceNumber() const   { return u64(ORIGINAL_ORDER_REFERENCE_NUMBER); }
+    uint64_t newOrderReferenceNumber() const        { return u64(NEW_ORDER_REFERENCE_NUMBER); }
+    uint32_t shares() const                         { return u32(SHARES); }
+    uint32_t price() const                          { return u32(PRICE); }
+};
+static_assert(OrderReplaceView::PRICE + 4 == MessageLength<OrderReplaceMessageType>);
+
+class TradeView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t ORDER_REFERENCE_NUMBER  = 11;
+    static constexpr size_t BUY_SELL_INDICATOR      = 19;
+    static constexpr size_t SHARES                  = 20;
+    static constexpr size_t STOCK                   = 24;   // 8 bytes, space padded
+    static constexpr size_t PRICE                   = 32;
+    static constexpr size_t MATCH_NUMBER            = 36;
+
+    uint64_t        orderReferenceNumber() const    { return u64(ORDER_REFERENCE_NUMBER); }
+    char            buySellIndicator() const        { return c(BUY_SELL_INDICATOR); }
+    uint32_t        shares() const                  { return u32(SHARES); }
+    char const *    stock() const                   { return bytes(STOCK); }
+    uint32_t        price() const                   { return u32(PRICE); }
+    uint64_t        matchNumber() const             { return u64(MATCH_NUMBER); }
+};
+static_assert(TradeView::MATCH_NUMBER + 8 == MessageLength<TradeMessageType>);
+
+class CrossTradeView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t SHARES          = 11;   // 8 bytes
+    static constexpr size_t STOCK           = 19;   // 8 bytes, space padded
+    static constexpr size_t CROSS_PRICE     = 27;
+    static constexpr size_t MATCH_NUMBER    = 31;
+    static constexpr size_t CROSS_TYPE      = 39;
+
+    uint64_t        shares() const          { return u64(SHARES); }
+    char const *    stock() const           { return bytes(STOCK); }
+    uint32_t        crossPrice() const      { return u32(CROSS_PRICE); }
+    uint64_t        matchNumber() const     { return u64(MATCH_NUMBER); }
+    char            crossType() const       { return c(CROSS_TYPE); }
+};
+static_assert(CrossTradeView::CROSS_TYPE + 1 == MessageLength<CrossTradeMessageType>);
+
+class BrokenTradeView : public MessageView {
+public:
+    using MessageView::MessageView;
+    static constexpr size_t MATCH_NUMBER = 11;
+
+    uint64_t matchNumber() const { return u64(MATCH_NUMBER); }
+};
+static_assert(BrokenTradeView::MATCH_NUMBER + 8 == MessageLength<BrokenTradeMessageType>);
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_ITCH_VIEWS_HPP
@@ -0,0 +1,235 @@
+#ifndef ORDER_BOOK_LEVEL_STORE_HPP
+#define ORDER_BOOK_LEVEL_STORE_HPP
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <sparsehash/dense_hash_map>
+
+// select the level store backend at build time
+// e.g. make rel DEFS=-DLEVEL_LADDER=true
+#ifndef LEVEL_LADDER
+#define LEVEL_LADDER false
+#endif
+
+struct Level;
+
+// Levels of one side of a book keyed by limit price
+// best() is the highest bid or the lowest offer
+// both stores only index Levels, allocation is left to the OrderBook
+
+// The last SIZE levels emptied on one side, out of the store but not freed
+// a level refilled at the same price before SIZE others empty is revived as it was, with whatever
+// the store needs to put it back without allocating (Node, e.g. its tree node)
+template <typename Node>
+class LevelRing {
+public:
+    static constexpr size_t SIZE = 8;
+
+    // the level pushed out to make room, for the caller to free, or nullptr
+    Level * push(uint32_t price, Level * level, Node && node) {
+        size_t const slot = next++ % SIZE;
+        Level * const evicted = levels[slot];
+        prices[slot] = price;
+        levels[slot] = level;
+        nodes[slot] = std::move(node);
+        return evicted;
+    }
+    // the level kept at price and its node, nullptr if none
+    Level * take(uint32_t price, Node & node) {
+        for (size_t slot = 0; slot < SIZE; ++slot) {
+            if (prices[slot] != price || !levels[slot]) continue;
+            Level * const level = levels[slot];
+            levels[slot] = nullptr;
+            node = std::move(nodes[slot]);
+            return level;
+        }
+        return nullptr;
+    }
+    template <typename F>
+    void forEach(F && f) const {
+        for (Level * level : levels) if (level) f(level);
+    }
+
+private:
+    uint32_t    prices[SIZE] = {};
+    Level *     levels[SIZE] = {};
+    Node        nodes[SIZE];
+    size_t      next = 0;
+};
+
+// <price, Level> sorted log(n) for L1 plus <price, Level> hash map for o(1) lookup
+class LevelTree {
+public:
+    explicit LevelTree(char side);
+
+    Level * find(uint32_t price) const {
+        auto const it = levels.find(price);
+        return it != levels.end() ? it->second : nullptr;
+    }
+    Level * best() const {
+        if (sorted.empty()) return nullptr;
+        return isBid ? sorted.rbegin()->second : sorted.begin()->second;
+    }
+    void insert(Level *);
+    void erase(uint32_t price);
+    // erase an emptied level into the retention ring, returns the level it pushed out (to be freed) or nullptr
+    // its tree node is kept, so revive() allocates nothing
+    Level * retire(Level *);
+    // put back the level retired at price, nullptr if it is no longer kept
+    Level * revive(uint32_t price);
+    template <typename F>
+    void forEachRetired(F && f) const { retired.forEach(f); }
+    size_t size() const { return levels.size(); }
+    // number of levels better than price, at most limit
+    size_t depthOf(uint32_t price, size_t limit) const;
+    // nth best level, 0 is best(), nullptr if there are fewer
+    Level * nth(size_t n) const;
+    // an empty store drops the deleted entries of its hash map, keeping the buckets
+    void reset();
+
+    // visits levels from best to worst while f returns true
+    template <typename F>
+    void forEachWhile(F && f) const {
+        if (isBid) for (auto it = sorted.rbegin(); it != sorted.rend() && f(it->second); ++it);
+        else for (auto it = sorted.begin(); it != sorted.end() && f(it->second); ++it);
+    }
+    // visits levels from best to worst
+    template <typename F>
+    void forEach(F && f) const {
+        forEachWhile([&f](Level * level) { f(level); return true; });
+    }
+
+private:
+    using Node = std::map<uint32_t, Level*>::node_type;
+
+    bool const isBid;
+    std::map<uint32_t, Level*> sorted;
+    google::dense_hash_map<uint32_t, Level*> levels;
+    LevelRing<Node> retired;
+};
+
+// Contiguous array of Level* indexed by tick, covering a window of prices around the touch
+// Lookup is an index computation and the best level is a cached slot, no hashing or tree walk
+// Prices outside the window (or off the tick grid) overflow into a sorted tree
+// The window is re-centred on the best overflow level once it empties, and on a new touch outside it only
+// while it holds at most RECENTRE_THRESHOLD levels, otherwise that touch stays in the tree until the window drains
+class LevelLadder {
+public:
+    explicit LevelLadder(char side);
+
+    LevelLadder(LevelLadder const &)                = delete;
+    LevelLadder & operator=(LevelLadder const &)    = delete;
+
+    Level * find(uint32_t price) const {
+        uint32_t const slot = slotOf(price);
+        if (slot != NO_SLOT) return slots[slot];
+        if (overflow.empty()) return nullptr;
+        auto const it = overflow.find(price);
+        return it != overflow.end() ? it->second : nullptr;
+    }
+    Level * best() const {
+        if (overflow.empty()) return windowCount ? slots[bestSlot] : nullptr;
+        return bestWithOverflow();
+    }
+    void insert(Level *);
+    void erase(uint32_t price);
+    // as LevelTree, a window slot is only an index so just the Level is kept
+    Level * retire(Level *);
+    Level * revive(uint32_t price);
+    template <typename F>
+    void forEachRetired(F && f) const { retired.forEach(f); }
+    size_t size() const { return windowCount + overflow.size(); }
+    // number of levels better than price, at most limit
+    // a popcount of the window while nothing has overflowed
+    size_t depthOf(uint32_t price, size_t limit) const;
+    // nth best level, 0 is best(), nullptr if there are fewer
+    Level * nth(size_t n) const;
+    // nothing to drop, an empty window is recentred by the next insert
+    void reset() {}
+
+    // visits levels from best to worst while f returns true
+    template <typename F>
+    void forEachWhile(F && f) const {
+        auto ot = overflowFromBest();
+        uint32_t slot = bestSlot;
+        size_t remaining = windowCount;
+        while (remaining || ot.valid()) {
+            Level * const fromWindow = remaining ? slots[slot] : nullptr;
+            if (fromWindow && (!ot.valid() || better(slotPrice(slot), ot.price()))) {
+                if (!f(fromWindow)) return;
+                if (--remaining) slot = nextWorse(slot);
+            } else {
+                if (!f(ot.level())) return;
+                ot.advance();
+            }
+        }
+    }
+    // visits levels from best to worst
+    template <typename F>
+    void forEach(F && f) const {
+        forEachWhile([&f](Level * level) { f(level); return true; });
+    }
+
+    static constexpr uint32_t WINDOW_SLOTS  = 1024;                  // power of 2
+    static constexpr uint32_t DEFAULT_TICK  = 100;                   // $0.01 in ITCH price units
+    static constexpr uint32_t SUBPENNY_TICK = 1;                     // $0.0001, for sub dollar names
+
+private:
+    static constexpr uint32_t WORDS = WINDOW_SLOTS / 64;
+    static constexpr uint32_t NO_SLOT = WINDOW_SLOTS;
+    // a touch outside the window only moves it while it holds this few levels, recentring spills them all to the tree
+    static constexpr size_t RECENTRE_THRESHOLD = 4;
+
+    // NO_SLOT if price is outside the window or off the tick grid
+    uint32_t slotOf(uint32_t price) const {
+        if (price % tick) return NO_SLOT;
+        uint32_t const slot = price / tick - baseTick;  // wraps when below baseTick
+        return slot < WINDOW_SLOTS ? slot : NO_SLOT;
+    }
+    uint32_t slotPrice(uint32_t slot) const { return (baseTick + slot) * tick; }
+    bool better(uint32_t a, uint32_t b) const { return isBid ? a > b : a < b; }
+    uint32_t nextWorse(uint32_t slot) const { return isBid ? highestBelow(slot) : lowestAbove(slot); }
+    uint32_t highestBelow(uint32_t slot) const;     // highest occupied slot < slot, NO_SLOT if none
+    uint32_t lowestAbove(uint32_t slot) const;      // lowest occupied slot > slot, NO_SLOT if none
+    size_t occupiedBetter(uint32_t slot) const;     // occupied slots better than slot
+    Level * bestWithOverflow() const;
+    void recentre(uint32_t price);
+
+    // walks the overflow tree best to worst regardless of side
+    class OverflowCursor {
+    public:
+        OverflowCursor(std::map<uint32_t, Level*> const & m, bool _isBid)
+            : fwd(m.begin()), fwdEnd(m.end()), rev(m.rbegin()), revEnd(m.rend()), isBid(_isBid) {}
+        bool valid() const { return isBid ? rev != revEnd : fwd != fwdEnd; }
+        uint32_t price() const { return isBid ? rev->first : fwd->first; }
+        Level * level() const { return isBid ? rev->second : fwd->second; }
+        void advance() { if (isBid) ++rev; else ++fwd; }
+    private:
+        std::map<uint32_t, Level*>::const_iterator fwd, fwdEnd;
+        std::map<uint32_t, Level*>::const_reverse_iterator rev, revEnd;
+        bool isBid;
+    };
+    OverflowCursor overflowFromBest() const { return OverflowCursor(overflow, isBid); }
+
+    bool const                      isBid;
+    uint32_t                        tick;
+    uint32_t                        baseTick;       // price of slot 0 is baseTick * tick
+    uint32_t                        bestSlot;
+    size_t                          windowCount;
+    std::unique_ptr<Level*[]>       slots;          // allocated on first insert
+    uint64_t                        occupied[WORDS];
+    std::map<uint32_t, Level*>      overflow;
+    struct NoNode {};
+    LevelRing<NoNode>               retired;
+};
+
+#if LEVEL_LADDER
+using LevelStore = LevelLadder;
+#else
+using LevelStore = LevelTree;
+#endif
+
+#endif // ORDER_BOOK_LEVEL_STORE_HPP
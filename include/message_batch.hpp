@@ -0,0 +1,51 @@
+#ifndef ORDER_BOOK_MESSAGE_BATCH_HPP
+#define ORDER_BOOK_MESSAGE_BATCH_HPP
+
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+namespace ITCH {
+
+// one framed message, length prefix included, messages are at most 2 + maxITCHMessageSize bytes
+struct alignas(64) MessageSlot {
+    char data[64];
+
+    // the readers frame any length, a message longer than every ITCH type is none the books handle
+    static bool fits(char const * messageData) {
+        return messageHeaderLength + Parser::getDataMessageLength(messageData) <= sizeof(data);
+    }
+};
+static_assert(sizeof(MessageSlot::data) >= messageHeaderLength + maxITCHMessageSize);
+
+// Window of messages copied out of the reader for the batched pipeline
+// the buffered reader reuses its buffer, so messages are copied rather than pointed to
+class MessageBatch {
+public:
+    explicit MessageBatch(size_t _capacity) : slots(_capacity), messages(_capacity), count(0) {}
+
+    // true once the batch is full, a message that does not fit a slot is skipped
+    bool push(char const * messageData) {
+        if (!MessageSlot::fits(messageData)) [[unlikely]] return false;
+        size_t const length = messageHeaderLength + Parser::getDataMessageLength(messageData);
+        std::memcpy(slots[count].data, messageData, length);
+        messages[count] = slots[count].data;
+        return ++count == slots.size();
+    }
+    void clear() { count = 0; }
+
+    char const * const * data() const { return messages.data(); }
+    size_t size() const { return count; }
+    bool empty() const { return !count; }
+
+private:
+    std::vector<MessageSlot>    slots;
+    std::vector<char const *>   messages;
+    size_t                      count;
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_MESSAGE_BATCH_HPP
@@ -2,33 +2,103 @@
 #define ORDER_BOOK_ORDER_BOOK_HPP
 
 #include "itch_common.hpp"
-#include <map>
+#include "itch_views.hpp"
+#include "depth_feed.hpp"
+#include "snapshot.hpp"
+#include "level_store.hpp"
+#include "order_index.hpp"
+#include "slab_pool.hpp"
 #include <cstdint>
-#include <tuple>
-#include <boost/pool/object_pool.hpp>
 #include <sparsehash/dense_hash_map>
 #define NDEBUG
 
+// 32 bytes, two orders per cache line
+// hot fields first: shares, price, side and the level links are touched by every add, execute, cancel and delete
+// cold fields after: reference number, timestamp and locate are only read by replace, the index and snapshots
+// prev/next are indices into the book's Order SlabPool, 0 for none
 struct Order {
-    uint64_t    referenceNumber;
-    uint16_t    stockLocate;
-    uint64_t    timestamp;
-    char        side;
     uint32_t    shares;
-    uint32_t    price;
-    Order*      prev;
-    Order*      next;
-    Order(const std::tuple<uint64_t, uint16_t, uint64_t, char, uint32_t, uint32_t, Order*, Order*> &);
+    uint32_t    price       : 31;   // ITCH prices top out at 200,000.0000, below 2^31
+    uint32_t    buy         : 1;
+    uint32_t    prev;
+    uint32_t    next;
+
+    uint64_t    referenceNumber;
+    uint64_t    timestamp   : 48;   // ITCH timestamps are 6 bytes
+    uint64_t    stockLocate : 16;
+
+    Order(uint64_t referenceNumber, uint16_t stockLocate, uint64_t timestamp, char side, uint32_t shares, uint32_t price);
+
+    char side() const { return buy ? ITCH::Side::BUY : ITCH::Side::SELL; }
 };
 
 struct Level {
     uint32_t price;
     uint32_t limitVolume;
-    // either both are nullptr or both are populated
-    // i.e. if orders in Level == 1, both pointers are ==
-    Order* first;
-    Order* last;
-    Level(uint32_t _price);
+    // Order SlabPool indices, either both are 0 or both are populated
+    // i.e. if orders in Level == 1, both indices are ==
+    uint32_t first;
+    uint32_t last;
+    explicit Level(uint32_t _price);
+};
+
+// top of one side, all 0 while the side is empty
+struct Quote {
+    uint32_t price;
+    uint32_t volume;
+    uint32_t orders;
+    bool operator==(Quote const &) const = default;
+};
+
+struct BBO {
+    Quote bid;
+    Quote ask;
+    bool operator==(BBO const &) const = default;
+};
+
+// layout budget, growing either record costs cache lines on every message
+static_assert(sizeof(Order) == 32, "Order must stay at two per cache line");
+static_assert(sizeof(Level) == 16, "Level must stay at four per cache line");
+
+// how often the fast paths of OrderBook are taken, summed over the books of a thread
+struct PathCounters {
+    uint64_t replaces           = 0;
+    uint64_t replacesInPlace    = 0;    // same price, requeued at the back of its level
+    uint64_t reductions         = 0;    // partial executions and cancels
+    uint64_t reductionsAtTouch  = 0;    // on the best level, taken without a lookup
+    uint64_t levelsEmptied      = 0;
+    uint64_t levelsRevived      = 0;    // refilled at the same price from the retention ring
+
+    PathCounters & operator+=(PathCounters const & o) {
+        replaces            += o.replaces;
+        replacesInPlace     += o.replacesInPlace;
+        reductions          += o.reductions;
+        reductionsAtTouch   += o.reductionsAtTouch;
+        levelsEmptied       += o.levelsEmptied;
+        levelsRevived       += o.levelsRevived;
+        return *this;
+    }
+};
+
+// Order and Level memory shared by every book built on one thread, and their counters
+struct BookPools {
+    struct Config {
+        size_t  orderCapacity   = 1 << 28;  // address space only, above the ~140M orders in a day
+        size_t  levelCapacity   = 1 << 26;
+        size_t  reserveOrders   = 0;        // committed up front, levels are reserved at ~5 orders per level
+        bool    hugePages       = false;
+    };
+
+    explicit BookPools(Config const & config) :
+        orders(config.orderCapacity, config.hugePages),
+        levels(config.levelCapacity, config.hugePages) {
+        orders.reserve(config.reserveOrders);
+        levels.reserve(config.reserveOrders / 5);
+    }
+
+    SlabPool<Order> orders;
+    SlabPool<Level> levels;
+    PathCounters    counters;
 };
 
 // price-time LOB
@@ -58,34 +128,100 @@ public:
     void handleRetailInterestMessage(ITCH::RetailInterestMessage const &);
     void handleDirectListingWithCapitalRaisePriceDiscoveryMessage(ITCH::DirectListingWithCapitalRaisePriceDiscoveryMessage const &);
 
+    // zero-copy overloads, only the fields the book uses are decoded
+    void handleAddOrderMessage(ITCH::AddOrderView const &);
+    void handleAddOrderMPIDAttributionMessage(ITCH::AddOrderMPIDAttributionView const &);
+    void handleOrderExecutedMessage(ITCH::OrderExecutedView const &);
+    void handleOrderExecutedWithPriceMessage(ITCH::OrderExecutedWithPriceView const &);
+    void handleOrderCancelMessage(ITCH::OrderCancelView const &);
+    void handleOrderDeleteMessage(ITCH::OrderDeleteView const &);
+    void handleOrderReplaceMessage(ITCH::OrderReplaceView const &);
+
     uint32_t getLimitVolume(char side, uint32_t limitprice) const; // keep track Level obj
-    uint32_t getBestBid() const;   // largest map
-    uint32_t getBestAsk() const;   // lowest map
-    uint32_t getLastExecutedPrice() const;  // keep track in book
-    uint32_t getLastExecutedSize() const;   // keep track in book
+    uint32_t getBestBid() const;   // cached, see getBBO
+    uint32_t getBestAsk() const;   // cached, see getBBO
+    // kept up to date by every add, execute, cancel and delete, no level store lookup
+    BBO const & getBBO() const { return bbo; }
+    // set whenever the BBO changes, cleared by whoever publishes it, see BookSet
+    bool bboChanged() const { return bboDirty; }
+    void clearBboChanged() { bboDirty = false; }
+    // the last execution against a resting order (E or C, printable or not), kept across reset()
+    uint32_t getLastExecutedPrice() const;
+    uint32_t getLastExecutedSize() const;
     size_t orderCount () const; // number of orders in book
+    // back to a new book's state once empty, keeping what it has allocated, see BookSet
+    void reset();
+
+#if FLAT_ORDER_INDEX
+    // hints for the batched pipeline, see BookSet::handleBatch, the book is only read
+    // a flat index slot has an address before it is looked up, a hash bucket or a level does not
+    void prefetchIndex(uint64_t orderReferenceNumber) const;        // index entry of an order
+    void prefetchOrder(uint64_t orderReferenceNumber) const;        // the order itself, once its entry has landed
+#endif
+
+    // snapshots, see snapshot.hpp
+    // orders of each side best level first, each level in queue order
+    void writeSnapshot(SnapshotWriter &, uint16_t stockLocate) const;
+    // appended to the back of its level's queue, as an add would be
+    void restoreOrder(uint64_t orderReferenceNumber, uint16_t stockLocate, uint64_t timestamp, char side, uint32_t shares, uint32_t price);
 
-    OrderBook();
+    // with a DepthFeed every change to the top depth->levels() levels of either side is published to it
+    explicit OrderBook(BookPools &, DepthFeed * depth = nullptr);
+    ~OrderBook();
 
 private:
 
+    void add(uint64_t orderReferenceNumber, uint16_t stockLocate, uint64_t timestamp, char side, uint32_t shares, uint32_t price);
+    void execute(uint64_t orderReferenceNumber, uint32_t executedShares);
+    void cancel(uint64_t orderReferenceNumber, uint32_t cancelledShares);
+    void replace(uint64_t originalOrderReferenceNumber, uint64_t newOrderReferenceNumber, uint64_t timestamp, uint32_t shares, uint32_t price);
+
     void addOrder(Order*);
     void deleteOrder(uint64_t orderReferenceNumber);
+    // an indexed order onto the back of its level / off its level, a level is revived or retired as needed
+    void linkOrder(Order*);
+    void unlinkOrder(Order*);
+    // the level of an order being reduced, the best one is checked first
+    Level * reducedLevel(LevelStore const &, Order const &);
+
+    // BBO cache
+    void quoteAdded(Level const &, Order const &, bool newLevel);
+    void quoteReduced(Order const &, uint32_t shares);
+    void quoteResized(Level const &, Order const &);
+    void quoteRemoved(LevelStore const &, Order const &, bool levelRemoved);
+
+    // depth feed, only called when there is one
+    void publishChange(LevelStore const &, Level const &, Order const &);
+    void publishNew(LevelStore const &, Level const &, Order const &);
+    void publishDelete(LevelStore const &, size_t depth, Order const &);
+
+    Order * findOrder(uint64_t orderReferenceNumber) const;
+    void indexOrder(Order*);
+    void unindexOrder(uint64_t orderReferenceNumber);
+    void resetIndex();
 
-    // <price, Level> sorted log(n)
-    std::map<uint32_t, Level*> sortedBidLimits;
-    std::map<uint32_t, Level*> sortedOfferLimits;
+    // <price, Level> one store for each side in case same price
+    // sorted tree + hash map, or price ladder, see level_store.hpp
+    LevelStore bids;
+    LevelStore offers;
 
     // quick access
     // <referenceNumber, Order>
+#if FLAT_ORDER_INDEX
+    // one index shared by every book on a thread, reference numbers are unique across symbols
+    // books of one locate are always built on the same thread, see BookWorkers
+    static thread_local OrderIndex orders;
+    size_t numOrders;
+#else
     google::dense_hash_map<uint64_t, Order*> orders;
-    // <price, Level> o(1)
-    // map for each side in case same price
-    google::dense_hash_map<uint32_t, Level*> levelBids;
-    google::dense_hash_map<uint32_t, Level*> levelOffers;
+#endif
 
-    boost::object_pool<Order> ordersmem;
-    boost::object_pool<Level> levelsmem;
+    BookPools & pools;
+    DepthFeed * depth;
+    BBO bbo;
+    bool bboDirty;
+    uint32_t lastExecutedPrice;
+    uint32_t lastExecutedSize;
 
     template <typename OStream>
     friend OStream& operator<<(OStream&, OrderBook const &);
@@ -98,7 +234,7 @@ inline OStream& operator<<(OStream& os, Order const & o) {
         o.referenceNumber << "," <<
         o.stockLocate << "," <<
         o.timestamp << "," <<
-        o.side << "," <<
+        o.side() << "," <<
         o.shares << "," <<
         o.price << "," <<
         o.prev << "," <<
@@ -106,35 +242,30 @@ inline OStream& operator<<(OStream& os, Order const & o) {
     return os;
 }
 
+template <typename OStream>
+inline OStream& operator<<(OStream& os, PathCounters const & c) {
+    os << "replaces: " << c.replaces << " (in place " << c.replacesInPlace << ")"
+        << ", partial executions/cancels: " << c.reductions << " (at the touch " << c.reductionsAtTouch << ")"
+        << ", levels emptied: " << c.levelsEmptied << " (revived " << c.levelsRevived << ")";
+    return os;
+}
+
+// orders are linked by pool index, walk them with OrderBook's operator<<
 template <typename OStream>
 inline OStream& operator<<(OStream& os, Level const & l) {
-    os << "Level: " << &l << " " << "first: " << l.first << " last: " << l.last << " volume: " << l.limitVolume << std::endl;
-    Order const * it = l.first;
-    std::string prefix = ">";
-    while (it) {
-        os << prefix << it << ": " << *it << std::endl;
-        prefix += ">";
-        it = it->next;
-    }
+    os << "Level: " << &l << " price: " << l.price << " first: " << l.first << " last: " << l.last << " volume: " << l.limitVolume;
     return os;
 }
 
 template <typename OStream>
 inline OStream& operator<<(OStream& os, OrderBook const & b) {
-    for (const auto& [_, level] : b.levelBids) {
-        Order* o = level->first;
-        while (o) {
+    auto const showLevel = [&os, &b](Level const * level) {
+        for (Order const * o = b.pools.orders.at(level->first); o; o = b.pools.orders.at(o->next)) {
             os << *o << "\n";
-            o = o->next;
         }
-    }
-    for (const auto& [_, level] : b.levelOffers) {
-        Order* o = level->first;
-        while (o) {
-            os << *o << "\n";
-            o = o->next;
-        }
-    }
+    };
+    b.bids.forEach(showLevel);
+    b.offers.forEach(showLevel);
     return os;
 }
 
@@ -0,0 +1,70 @@
+#ifndef ORDER_BOOK_ORDER_INDEX_HPP
+#define ORDER_BOOK_ORDER_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <sparsehash/dense_hash_map>
+
+// select the order index at build time
+// e.g. make rel DEFS=-DFLAT_ORDER_INDEX=true
+#ifndef FLAT_ORDER_INDEX
+#define FLAT_ORDER_INDEX false
+#endif
+
+struct Order;
+
+// <referenceNumber, Order> directly indexed, no hashing, tombstones or rehashing
+// ITCH reference numbers are assigned close to sequentially through the day
+// so the table is split into pages which are allocated as reference numbers reach them
+// and released once every order in them is gone
+// reference numbers beyond the page table fall back to a hash map
+class OrderIndex {
+public:
+    OrderIndex();
+    explicit OrderIndex(uint64_t expectedReferenceNumbers);    // presize page table
+
+    OrderIndex(OrderIndex const &)                  = delete;
+    OrderIndex & operator=(OrderIndex const &)      = delete;
+
+    ~OrderIndex();
+
+    Order * find(uint64_t referenceNumber) const {
+        uint64_t const page = referenceNumber >> PAGE_BITS;
+        if (page < pages.size()) [[likely]] {
+            Page const * const p = pages[page];
+            return p ? p->slots[referenceNumber & PAGE_MASK] : nullptr;
+        }
+        return findFar(referenceNumber);
+    }
+    // pull the slot for referenceNumber towards the cache ahead of find
+    void prefetch(uint64_t referenceNumber) const {
+        uint64_t const page = referenceNumber >> PAGE_BITS;
+        if (page < pages.size() && pages[page]) __builtin_prefetch(&pages[page]->slots[referenceNumber & PAGE_MASK]);
+    }
+    void insert(uint64_t referenceNumber, Order *);
+    void erase(uint64_t referenceNumber);
+    size_t size() const { return count; }
+
+    static constexpr uint64_t PAGE_BITS     = 16;
+    static constexpr uint64_t PAGE_SIZE     = 1ULL << PAGE_BITS;
+    static constexpr uint64_t PAGE_MASK     = PAGE_SIZE - 1;
+    static constexpr uint64_t MAX_PAGES     = 1ULL << 20;  // 2^36 reference numbers
+    static constexpr size_t   SPARE_PAGES   = 4;           // released pages kept for reuse
+
+private:
+    struct Page {
+        Order *     slots[PAGE_SIZE];
+        uint32_t    live;
+    };
+
+    Order * findFar(uint64_t referenceNumber) const;
+    Page * newPage();
+
+    std::vector<Page *>                         pages;
+    std::vector<Page *>                         spare;
+    google::dense_hash_map<uint64_t, Order*>    far;
+    size_t                                      count;
+};
+
+#endif // ORDER_BOOK_ORDER_INDEX_HPP
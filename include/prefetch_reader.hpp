@@ -0,0 +1,66 @@
+#ifndef ORDER_BOOK_PREFETCH_READER_HPP
+#define ORDER_BOOK_PREFETCH_READER_HPP
+
+#include "itch_common.hpp"
+#include "chunk_stream.hpp"
+#include <memory>
+#include <thread>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace ITCH {
+
+// Reads BinaryFILE ahead of the reading thread, so a slow read() stalls the I/O thread rather than the books
+// an I/O thread keeps up to `chunks` reads of CHUNK_BYTES in flight through io_uring where the kernel allows it,
+// or reads them one at a time with pread() otherwise
+// the reading thread frames messages out of chunks that are already filled (see ChunkStream),
+// messages split across chunks are completed in the next chunk's pad, the chunks are not shuffled
+// the file is read up to its size when opened
+class PrefetchReader {
+public:
+    enum class Backend { AUTO, URING, THREAD };
+
+    PrefetchReader()                                        = delete;   // must provide filename
+
+    // starts at startOffset, which must be the first byte of a message's length prefix
+    // URING throws if io_uring is unavailable, AUTO falls back to THREAD
+    PrefetchReader(char const * _filename, uint64_t startOffset = 0, Backend = Backend::AUTO, size_t chunks = DEFAULT_CHUNKS);
+
+    PrefetchReader(const PrefetchReader& p)                 = delete;
+    PrefetchReader& operator=(const PrefetchReader& p)      = delete;
+
+    ~PrefetchReader();
+
+    char const * nextMessage() { return stream.nextMessage(); }
+    long long getTotalBytesRead() const;    // since the start offset
+    uint64_t getOffset() const;             // file offset of the next message
+
+    // URING or THREAD, whichever is reading
+    Backend backend() const { return io; }
+
+    static constexpr size_t CHUNK_BYTES     = 4 << 20;
+    static constexpr size_t DEFAULT_CHUNKS  = 8;
+
+private:
+    struct Uring;   // a submission and completion queue pair, set up with the raw syscalls
+
+    void readUring();
+    void readThread();
+    // bytes of chunk n
+    size_t chunkBytes(uint64_t n) const;
+
+    std::string const   filename;
+    int const           fd;
+    uint64_t const      startOffset;
+    uint64_t            fileBytes;      // from startOffset
+    uint64_t            chunkCount;     // to the end of the file, the last one is short or empty
+    Backend             io;
+    std::unique_ptr<Uring> ring;
+    ChunkStream         stream;
+    std::thread         thread;
+};
+
+} // namespace ITCH
+
+#endif // ORDER_BOOK_PREFETCH_READER_HPP
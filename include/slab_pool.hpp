@@ -0,0 +1,117 @@
+#ifndef ORDER_BOOK_SLAB_POOL_HPP
+#define ORDER_BOOK_SLAB_POOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <sys/mman.h>               // mmap, madvise
+#include <unistd.h>                 // sysconf
+
+// Fixed size object pool over a single reserved range of address space
+// freed objects go on an intrusive LIFO free list, so construct and destroy are O(1)
+// the range is reserved for capacity objects up front but only committed as it is used,
+// or eagerly with reserve()
+// objects never move, so an object's index in the range is stable and can stand in for a pointer
+// index 0 is never handed out and means null
+template <typename T>
+class SlabPool {
+    static_assert(std::is_trivially_destructible_v<T>, "pool memory is released without running destructors");
+
+public:
+    static constexpr uint32_t NULL_INDEX = 0;
+
+    SlabPool(size_t _capacity, bool hugePages) :
+        capacity(_capacity),
+        mappedBytes(_capacity * sizeof(Slot)),
+        slots(nullptr),
+        bump(1),
+        freeList(nullptr),
+        live(0) {
+        if (_capacity > UINT32_MAX) throw std::invalid_argument("SlabPool capacity must fit a 32 bit index");
+        void * mapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        // explicit huge pages only exist if the admin reserved them, fall back to transparent ones
+        // no MAP_NORESERVE here, the mapping must fail now rather than SIGBUS on first touch
+        if (hugePages) mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (mapping == MAP_FAILED) {
+            mapping = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mapping == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            if (hugePages) madvise(mapping, mappedBytes, MADV_HUGEPAGE);
+#endif
+        }
+        slots = static_cast<Slot *>(mapping);
+    }
+
+    SlabPool(SlabPool const &)              = delete;
+    SlabPool & operator=(SlabPool const &)  = delete;
+
+    ~SlabPool() {
+        munmap(slots, mappedBytes);
+    }
+
+    template <typename... Args>
+    T * construct(Args &&... args) {
+        Slot * slot = freeList;
+        if (slot) {
+            freeList = slot->next;
+        } else {
+            if (bump == capacity) [[unlikely]] throw std::bad_alloc();
+            slot = &slots[bump++];
+        }
+        ++live;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T * object) {
+        Slot * const slot = reinterpret_cast<Slot *>(object);
+        slot->next = freeList;
+        freeList = slot;
+        --live;
+    }
+
+    // commit memory for the first n objects now rather than faulting it in during the day
+    void reserve(size_t n) {
+        if (!n) return;
+        // + 1 for the null slot
+        size_t const bytes = std::min(n + 1, capacity) * sizeof(Slot);
+#ifdef MADV_POPULATE_WRITE
+        if (!madvise(slots, bytes, MADV_POPULATE_WRITE)) return;
+#endif
+        size_t const page = sysconf(_SC_PAGESIZE);
+        char volatile * const bytesBase = reinterpret_cast<char *>(slots);
+        for (size_t offset = 0; offset < bytes; offset += page) bytesBase[offset] = 0;
+    }
+
+    uint32_t index(T const * object) const {
+        return object ? static_cast<uint32_t>(reinterpret_cast<Slot const *>(object) - slots) : NULL_INDEX;
+    }
+
+    T * at(uint32_t i) const {
+        return i ? reinterpret_cast<T *>(slots[i].storage) : nullptr;
+    }
+
+    size_t size() const { return live; }
+    size_t getCapacity() const { return capacity; }
+
+private:
+    union Slot {
+        Slot * next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    size_t const    capacity;
+    size_t const    mappedBytes;
+    Slot *          slots;
+    size_t          bump;       // slots below have been handed out at least once, slot 0 is the null index
+    Slot *          freeList;
+    size_t          live;
+};
+
+#endif // ORDER_BOOK_SLAB_POOL_HPP
@@ -0,0 +1,128 @@
+#ifndef ORDER_BOOK_SNAPSHOT_HPP
+#define ORDER_BOOK_SNAPSHOT_HPP
+
+#include "itch_common.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Binary snapshot of every resting order, host byte order
+//   header  magic "OBSNAP", version, book count, ITCH file offset, message count, timestamp, ITCH file size
+//   book    stock locate, bid level count, ask level count, then the levels of each side best to worst
+//   level   price, order count, then the orders in queue order
+//   order   reference number, timestamp (48 bits), shares
+// restoring re-adds the orders in file order, which rebuilds every queue as it was
+
+// where the snapshot was taken in the ITCH file, replay resumes from offset
+struct SnapshotInfo {
+    uint64_t    offset      = 0;    // of the first message not yet applied
+    uint64_t    messages    = 0;    // applied before offset
+    uint64_t    timestamp   = 0;    // snapshot time, ns since midnight
+    uint64_t    fileBytes   = 0;    // st_size of the ITCH file, compressed or not, offset only means something in that file
+};
+
+class SnapshotWriter {
+public:
+    SnapshotWriter(char const * filename, SnapshotInfo const &);
+    ~SnapshotWriter();
+
+    SnapshotWriter(SnapshotWriter const &)              = delete;
+    SnapshotWriter & operator=(SnapshotWriter const &)  = delete;
+
+    void book(uint16_t stockLocate, uint32_t bidLevels, uint32_t askLevels) {
+        put(stockLocate);
+        put(bidLevels);
+        put(askLevels);
+        ++books;
+    }
+    void level(uint32_t price, uint32_t orders) {
+        put(price);
+        put(orders);
+    }
+    void order(uint64_t referenceNumber, uint64_t timestamp, uint32_t shares) {
+        put(referenceNumber);
+        put(static_cast<uint32_t>(timestamp));
+        put(static_cast<uint16_t>(timestamp >> 32));
+        put(shares);
+    }
+
+    // flush and fill in the book count, also done on destruction
+    void finish();
+
+private:
+    template <typename T>
+    void put(T value) {
+        if (used + sizeof(T) > buffer.size()) flush();
+        std::memcpy(buffer.data() + used, &value, sizeof(T));
+        used += sizeof(T);
+    }
+    void flush();
+
+    FILE *              out;
+    std::vector<char>   buffer;
+    size_t              used;
+    uint32_t            books;
+};
+
+class SnapshotReader {
+public:
+    // maps the file and checks its structure, throws if it is not a complete snapshot
+    explicit SnapshotReader(char const * filename);
+    ~SnapshotReader();
+
+    SnapshotReader(SnapshotReader const &)              = delete;
+    SnapshotReader & operator=(SnapshotReader const &)  = delete;
+
+    SnapshotInfo const & info() const { return header; }
+    uint32_t bookCount() const { return books; }
+
+    // f(stockLocate, side, price, referenceNumber, timestamp, shares) for every order in file order
+    // books for which keep(stockLocate) is false are skipped whole
+    template <typename Keep, typename F>
+    void forEachOrder(Keep && keep, F && f) const {
+        char const * p = data + HEADER_BYTES;
+        for (uint32_t b = 0; b < books; ++b) {
+            uint16_t const stockLocate = get<uint16_t>(p);
+            uint32_t const levelCount[2] = {get<uint32_t>(p), get<uint32_t>(p)};
+            bool const kept = keep(stockLocate);
+            for (int side = 0; side < 2; ++side) {
+                for (uint32_t l = 0; l < levelCount[side]; ++l) {
+                    uint32_t const price = get<uint32_t>(p);
+                    uint32_t const orders = get<uint32_t>(p);
+                    if (!kept) {
+                        p += size_t(orders) * ORDER_BYTES;
+                        continue;
+                    }
+                    for (uint32_t o = 0; o < orders; ++o) {
+                        uint64_t const referenceNumber = get<uint64_t>(p);
+                        uint64_t const timestampLow = get<uint32_t>(p);
+                        uint64_t const timestamp = timestampLow | uint64_t(get<uint16_t>(p)) << 32;
+                        uint32_t const shares = get<uint32_t>(p);
+                        f(stockLocate, side ? ITCH::Side::SELL : ITCH::Side::BUY, price, referenceNumber, timestamp, shares);
+                    }
+                }
+            }
+        }
+    }
+
+    static constexpr size_t HEADER_BYTES    = 8 + 4 + 4 + 4 * 8;
+    static constexpr size_t ORDER_BYTES     = 8 + 4 + 2 + 4;
+
+private:
+    template <typename T>
+    static T get(char const * & p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    char const *    data;
+    size_t          size;
+    SnapshotInfo    header;
+    uint32_t        books;
+};
+
+#endif // ORDER_BOOK_SNAPSHOT_HPP
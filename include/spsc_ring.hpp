@@ -0,0 +1,92 @@
+#ifndef ORDER_BOOK_SPSC_RING_HPP
+#define ORDER_BOOK_SPSC_RING_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free single producer single consumer queue
+// head/tail live on separate cache lines and each side caches the other's index
+// so the shared lines are only touched when the cached view runs out
+template <typename T>
+class SpscRing {
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // capacity is rounded up to a power of 2
+    explicit SpscRing(size_t _capacity) :
+        capacity(roundUp(_capacity)),
+        mask(capacity - 1),
+        slots(new T[capacity]) {}
+
+    SpscRing(SpscRing const &)              = delete;
+    SpscRing & operator=(SpscRing const &)  = delete;
+
+    // producer side
+    // returns nullptr if full, otherwise a slot to fill before publish()
+    T * claim() {
+        size_t const t = tail.value.load(std::memory_order_relaxed);
+        if (t - producerHeadCache.value == capacity) {
+            producerHeadCache.value = head.value.load(std::memory_order_acquire);
+            if (t - producerHeadCache.value == capacity) return nullptr;
+        }
+        return &slots[t & mask];
+    }
+    void publish() {
+        tail.value.store(tail.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool push(T const & item) {
+        T * const slot = claim();
+        if (!slot) return false;
+        *slot = item;
+        publish();
+        return true;
+    }
+
+    // consumer side
+    // returns nullptr if empty, otherwise the oldest slot, valid until release()
+    T * front() {
+        size_t const h = head.value.load(std::memory_order_relaxed);
+        if (h == consumerTailCache.value) {
+            consumerTailCache.value = tail.value.load(std::memory_order_acquire);
+            if (h == consumerTailCache.value) return nullptr;
+        }
+        return &slots[h & mask];
+    }
+    void release() {
+        head.value.store(head.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool pop(T & item) {
+        T * const slot = front();
+        if (!slot) return false;
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // either side, approximate while the other side is running
+    bool empty() const {
+        return head.value.load(std::memory_order_acquire) == tail.value.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    template <typename V>
+    struct alignas(CACHE_LINE) Padded { V value{}; };
+
+    size_t const                        capacity;
+    size_t const                        mask;
+    std::unique_ptr<T[]> const          slots;
+    Padded<std::atomic<size_t>>         head;               // next slot to consume
+    Padded<size_t>                      producerHeadCache;
+    Padded<std::atomic<size_t>>         tail;               // next slot to produce
+    Padded<size_t>                      consumerTailCache;
+};
+
+#endif // ORDER_BOOK_SPSC_RING_HPP
@@ -0,0 +1,82 @@
+#ifndef ORDER_BOOK_SYMBOL_FILTER_HPP
+#define ORDER_BOOK_SYMBOL_FILTER_HPP
+
+#include "itch_common.hpp"
+#include "itch_views.hpp"
+#include <bitset>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Keeps the messages of a set of tickers, decided from the message type and stock locate alone
+// locates are assigned per day, so they are learnt from the day's Stock Directory as it goes by
+// messages of other locates are dropped before they are decoded, copied to a worker or looked up in a book
+// locate 0 (system wide events) is always kept
+class SymbolFilter {
+public:
+    // tickers as in the Stock Directory, e.g. "AAPL" or "BRK A", at most 8 characters
+    explicit SymbolFilter(std::vector<std::string> const & tickers);
+
+    // "AAPL,MSFT,..."
+    static std::vector<std::string> parse(char const * list);
+    // one ticker per line
+    static std::vector<std::string> load(char const * filename);
+
+    bool pass(char const * messageData) {
+        ++seen;
+        ITCH::MessageView const view(messageData);
+        uint16_t const stockLocate = view.stockLocate();
+        if (locates[stockLocate] || !stockLocate) {
+            ++kept;
+            return true;
+        }
+        if (view.messageType() == ITCH::StockDirectoryMessageType && subscribe(ITCH::StockDirectoryView(messageData))) {
+            ++kept;
+            return true;
+        }
+        return false;
+    }
+    // only learns the locate of a directory message, e.g. for a replay that resumes past the directory
+    void learn(char const * messageData) {
+        ITCH::MessageView const view(messageData);
+        if (view.messageType() == ITCH::StockDirectoryMessageType) subscribe(ITCH::StockDirectoryView(messageData));
+    }
+
+    // the locate of a ticker seen in the directory
+    bool subscribed(uint16_t stockLocate) const { return locates[stockLocate]; }
+    // every ticker has been seen in the directory
+    bool complete() const { return resolvedCount == tickers.size(); }
+    std::vector<std::string> unresolved() const;
+    size_t tickerCount() const { return tickers.size(); }
+    size_t resolved() const { return resolvedCount; }
+    uint64_t messagesSeen() const { return seen; }
+    uint64_t messagesKept() const { return kept; }
+
+    // forget the locates and counts, for the next day's file
+    void reset();
+
+private:
+    bool subscribe(ITCH::StockDirectoryView const &);
+
+    std::bitset<1 << 16>                    locates;
+    // space padded 8 byte stock field -> index into tickers
+    std::unordered_map<uint64_t, size_t>    byStock;
+    std::vector<std::string>                tickers;
+    std::vector<bool>                       found;
+    size_t                                  resolvedCount;
+    uint64_t                                seen;
+    uint64_t                                kept;
+};
+
+template <typename OStream>
+inline OStream& operator<<(OStream& os, SymbolFilter const & f) {
+    os << "symbols: kept " << f.messagesKept() << " of " << f.messagesSeen() << " messages, "
+        << f.resolved() << " of " << f.tickerCount() << " tickers in the stock directory";
+    std::vector<std::string> const missing = f.unresolved();
+    for (size_t i = 0; i < missing.size(); ++i) os << (i ? " " : ", missing: ") << missing[i];
+    return os;
+}
+
+#endif // ORDER_BOOK_SYMBOL_FILTER_HPP
@@ -0,0 +1,52 @@
+#ifndef ORDER_BOOK_TIME_INDEX_HPP
+#define ORDER_BOOK_TIME_INDEX_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Where replay can start in an ITCH file without scanning it from the beginning
+// every message before offset has a timestamp of at most timestamp, and there are messages of them
+struct TimeCheckpoint {
+    uint64_t    timestamp;  // of the message at offset, ns since midnight
+    uint64_t    offset;     // of its length prefix, for Reader/MappedReader
+    uint64_t    messages;
+};
+
+// Checkpoints every N messages and every time the timestamp crosses into a new interval
+// stored next to the ITCH file as <itch_filename>.idx, host byte order
+// only itch-index reads it, order-book starts from the head of the file or a --restore snapshot's own offset
+//   header      magic "OBTIDX", version, checkpoint count, st_size of the ITCH file indexed
+//   checkpoint  timestamp, offset, messages
+class TimeIndex {
+public:
+    struct Interval {
+        uint64_t    messages    = 1 << 20;
+        uint64_t    nanoseconds = 1000000000;
+    };
+
+    // scans itchFilename, only the message headers are read
+    static TimeIndex build(char const * itchFilename, Interval const &);
+    // throws if the file is not a complete index, or not one of an ITCH file of itchBytes
+    TimeIndex(char const * indexFilename, uint64_t itchBytes);
+
+    void write(char const * indexFilename) const;
+
+    // the last checkpoint before every message at or after timestamp,
+    // so replay from it reads all of them, the first checkpoint is the start of the file
+    TimeCheckpoint const & seek(uint64_t timestamp) const;
+
+    std::vector<TimeCheckpoint> const & checkpoints() const { return entries; }
+    uint64_t fileBytes() const { return itchBytes; }
+
+    static std::string filenameFor(char const * itchFilename) { return std::string(itchFilename) + ".idx"; }
+
+private:
+    TimeIndex(std::vector<TimeCheckpoint> && _entries, uint64_t _itchBytes) : entries(std::move(_entries)), itchBytes(_itchBytes) {}
+
+    std::vector<TimeCheckpoint> entries;
+    uint64_t                    itchBytes;
+};
+
+#endif // ORDER_BOOK_TIME_INDEX_HPP
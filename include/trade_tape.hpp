@@ -0,0 +1,107 @@
+#ifndef ORDER_BOOK_TRADE_TAPE_HPP
+#define ORDER_BOOK_TRADE_TAPE_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+#include <sparsehash/dense_hash_map>
+
+// One OHLCV bar of a locate, 48 bytes in host byte order
+// prices are ITCH price units (4 implied decimals), VWAP is notional / volume
+struct BarRecord {
+    uint64_t    start       : 48;   // ns since midnight, a multiple of the interval
+    uint64_t    stockLocate : 16;
+    uint32_t    open;
+    uint32_t    high;
+    uint32_t    low;
+    uint32_t    close;
+    uint64_t    volume;
+    uint64_t    notional;           // sum of price * shares
+    uint32_t    trades;
+    uint32_t    revision;           // broken trades taken out of it, the highest revision of a bar supersedes the others
+};
+
+static_assert(sizeof(BarRecord) == 48, "BarRecord must stay at 48 bytes");
+
+// a locate's prints since the start of the session, net of broken trades
+struct TradeStats {
+    uint64_t    volume          = 0;
+    uint64_t    notional        = 0;
+    uint64_t    lastTimestamp   = 0;
+    uint32_t    trades          = 0;
+    uint32_t    lastPrice       = 0;
+    uint32_t    lastShares      = 0;
+
+    double vwap() const { return volume ? double(notional) / volume : 0; }
+};
+
+// Prints of the locates of one BookSet, and their bars written to a binary file
+// a bar is written once the first print of a later interval arrives, so the file is in interval order
+// every print is kept by match number until the end of the session, ~55 bytes each, so a broken trade
+// can be taken out of the totals and its bar rebuilt: in place while the bar is open, or written again
+// with the next revision once it has been written
+class TradeTape {
+public:
+    // bars of interval ns, aligned to midnight
+    TradeTape(char const * filename, uint64_t interval);
+    ~TradeTape();
+
+    TradeTape(TradeTape const &)                = delete;
+    TradeTape & operator=(TradeTape const &)    = delete;
+
+    // a printable execution, the caller leaves out non-printable ones
+    void print(uint64_t timestamp, uint16_t stockLocate, uint32_t price, uint32_t shares, uint64_t matchNumber);
+    // a broken trade, unknown match numbers (e.g. printed before a restored snapshot) are counted and skipped
+    void breakTrade(uint64_t timestamp, uint16_t stockLocate, uint64_t matchNumber);
+    // writes the open bars and everything buffered, at the end of the session
+    void finish();
+
+    TradeStats const & stats(uint16_t stockLocate) const { return totals[stockLocate]; }
+    uint64_t records() const { return written + buffer.size(); }
+    uint64_t printCount() const { return prints.size(); }
+    uint64_t brokenCount() const { return broken; }
+    uint64_t unmatchedCount() const { return unmatched; }
+
+private:
+    static constexpr size_t BUFFER_RECORDS = 1 << 14;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // 0 shares once broken
+    struct Print {
+        uint64_t    timestamp   : 48;
+        uint64_t    stockLocate : 16;
+        uint32_t    price;
+        uint32_t    shares;
+        uint32_t    previous;           // prints index of the locate's last print before it, or NONE
+    };
+
+    // the first print of a later interval writes every open bar
+    void advance(uint64_t timestamp);
+    void closeBars();
+    // the bar of stockLocate starting at start, from its prints
+    BarRecord rebuild(uint16_t stockLocate, uint64_t start) const;
+    void write(BarRecord const & record) {
+        buffer.push_back(record);
+        if (buffer.size() == BUFFER_RECORDS) flush();
+    }
+    void flush();
+
+    FILE *                                      out;
+    uint64_t const                              interval;
+    uint64_t                                    windowEnd;
+    std::vector<Print>                          prints;     // in arrival order, so by timestamp
+    google::dense_hash_map<uint64_t, uint32_t>  byMatch;    // match number -> prints index
+    std::vector<TradeStats>                     totals;     // by locate
+    std::vector<uint32_t>                       lastPrint;  // by locate, prints index or NONE
+    std::vector<BarRecord>                      bars;       // by locate, the bar of the current interval
+    std::bitset<1 << 16>                        opened;     // locates with a bar in the current interval
+    std::vector<uint16_t>                       open;
+    std::vector<BarRecord>                      buffer;
+    uint64_t                                    written;
+    uint64_t                                    broken;
+    uint64_t                                    unmatched;
+};
+
+#endif // ORDER_BOOK_TRADE_TAPE_HPP
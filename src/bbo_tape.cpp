@@ -0,0 +1,26 @@
+#include "bbo_tape.hpp"
+#include <stdexcept>
+#include <string>
+
+BboTape::BboTape(char const * filename, Conflation _mode) :
+    out(std::fopen(filename, "wb")),
+    mode(_mode),
+    written(0) {
+    if (!out) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    buffer.reserve(BUFFER_RECORDS);
+}
+
+// whatever is still buffered, errors can no longer be reported
+BboTape::~BboTape() {
+    std::fwrite(buffer.data(), sizeof(BboRecord), buffer.size(), out);
+    std::fclose(out);
+}
+
+void BboTape::flush() {
+    if (buffer.empty()) return;
+    if (std::fwrite(buffer.data(), sizeof(BboRecord), buffer.size(), out) != buffer.size()) {
+        throw std::runtime_error("Failed to write BBO tape");
+    }
+    written += buffer.size();
+    buffer.clear();
+}
@@ -0,0 +1,203 @@
+#include "book_set.hpp"
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "itch_dispatcher.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+BookSet::BookSet(BookPools::Config const & config, BookFeeds const & _feeds) : pools(config), feeds(_feeds), lastTimestamp(0), books(1 << 16, nullptr), created(0) {
+    if (feeds.bbo) bboWritten.resize(1 << 16);
+}
+
+BookSet::~BookSet() {
+    clear();
+}
+
+void BookSet::clear() {
+    if (feeds.bbo) publishBbo();
+    for (OrderBook *& book : books) {
+        if (!book) continue;
+        booksmem.destroy(book);
+        book = nullptr;
+    }
+    created = 0;
+}
+
+size_t BookSet::bookCount() const {
+    return created;
+}
+
+OrderBook * BookSet::getOrCreate(uint16_t stockLocate) {
+    OrderBook *& book = books[stockLocate];
+    if (!book) [[unlikely]] {
+        book = booksmem.construct(pools, feeds.depth);
+        ++created;
+    }
+    return book;
+}
+
+OrderBook const * BookSet::peek(uint16_t stockLocate) const {
+    return books[stockLocate];
+}
+
+// the book stays in the table, an active name empties and refills many times a day
+void BookSet::resetIfEmpty(OrderBook * book) {
+    if (!book->orderCount()) book->reset();
+}
+
+void BookSet::writeSnapshot(SnapshotWriter & out) const {
+    for (size_t stockLocate = 0; stockLocate < books.size(); ++stockLocate) {
+        OrderBook const * const book = books[stockLocate];
+        if (book && book->orderCount()) book->writeSnapshot(out, static_cast<uint16_t>(stockLocate));
+    }
+}
+
+void BookSet::handleMessage(char const * messageData) {
+    apply(messageData);
+    if (feeds.bbo && feeds.bbo->conflation() == BboTape::Conflation::BATCH) publishBbo();
+}
+
+void BookSet::apply(char const * messageData) {
+    if (!feeds.bbo) {
+        ITCH::Dispatcher<BookSet>::dispatch(*this, messageData);
+        return;
+    }
+    ITCH::Timestamp_t const timestamp = ITCH::Parser::getDataTimestamp(messageData);
+    if (timestamp != lastTimestamp && feeds.bbo->conflation() == BboTape::Conflation::TIMESTAMP) publishBbo();
+    lastTimestamp = timestamp;
+    ITCH::Dispatcher<BookSet>::dispatch(*this, messageData);
+    uint16_t const stockLocate = ITCH::Parser::getDataStockLocate(messageData);
+    OrderBook * const book = books[stockLocate];
+    if (book && book->bboChanged()) {
+        book->clearBboChanged();
+        queueBbo(stockLocate);
+    }
+}
+
+/*
+ * Conflated BBO
+ * a book's BBO can change many times within a window, it is queued on the first change
+ * and written once when the window closes, if it ends up different from the last one written
+ */
+void BookSet::queueBbo(uint16_t stockLocate) {
+    if (bboQueued[stockLocate]) return;
+    bboQueued[stockLocate] = true;
+    bboQueue.push_back(stockLocate);
+}
+
+void BookSet::publishBbo() {
+    for (uint16_t const stockLocate : bboQueue) {
+        bboQueued[stockLocate] = false;
+        BBO const bbo = books[stockLocate]->getBBO();
+        if (bbo == bboWritten[stockLocate]) continue;
+        bboWritten[stockLocate] = bbo;
+        feeds.bbo->write(BboRecord{lastTimestamp, stockLocate, bbo.bid, bbo.ask});
+    }
+    bboQueue.clear();
+}
+
+// books of the day's listings exist before their first order
+void BookSet::onMessage(ITCH::StockDirectoryView const & m) {
+    getOrCreate(m.stockLocate());
+}
+
+void BookSet::onMessage(ITCH::AddOrderView const & m) {
+    getOrCreate(m.stockLocate())->handleAddOrderMessage(m);
+}
+
+void BookSet::onMessage(ITCH::AddOrderMPIDAttributionView const & m) {
+    getOrCreate(m.stockLocate())->handleAddOrderMPIDAttributionMessage(m);
+}
+
+// an E prints at the price of the order it executes, which only the book knows
+void BookSet::onMessage(ITCH::OrderExecutedView const & m) {
+    OrderBook * const book = books[m.stockLocate()];
+    book->handleOrderExecutedMessage(m);
+    if (feeds.trades) feeds.trades->print(m.timestamp(), m.stockLocate(), book->getLastExecutedPrice(), m.executedShares(), m.matchNumber());
+    resetIfEmpty(book);
+}
+
+void BookSet::onMessage(ITCH::OrderExecutedWithPriceView const & m) {
+    OrderBook * const book = books[m.stockLocate()];
+    book->handleOrderExecutedWithPriceMessage(m);
+    // non-printable executions are printed by the cross they belong to
+    if (feeds.trades && m.printable() == 'Y') feeds.trades->print(m.timestamp(), m.stockLocate(), m.executionPrice(), m.executedShares(), m.matchNumber());
+    resetIfEmpty(book);
+}
+
+void BookSet::onMessage(ITCH::OrderCancelView const & m) {
+    // a cancel is always partial, it never empties a book
+    books[m.stockLocate()]->handleOrderCancelMessage(m);
+}
+
+void BookSet::onMessage(ITCH::OrderDeleteView const & m) {
+    OrderBook * const book = books[m.stockLocate()];
+    book->handleOrderDeleteMessage(m);
+    resetIfEmpty(book);
+}
+
+void BookSet::onMessage(ITCH::OrderReplaceView const & m) {
+    books[m.stockLocate()]->handleOrderReplaceMessage(m);
+}
+
+// executions of non-displayed orders, the book never held them
+void BookSet::onMessage(ITCH::TradeView const & m) {
+    if (feeds.trades) feeds.trades->print(m.timestamp(), m.stockLocate(), m.price(), m.shares(), m.matchNumber());
+}
+
+void BookSet::onMessage(ITCH::CrossTradeView const & m) {
+    // a cross that matched nothing is sent with 0 shares, none come near 2^32
+    if (feeds.trades && m.shares()) feeds.trades->print(m.timestamp(), m.stockLocate(), m.crossPrice(), static_cast<uint32_t>(m.shares()), m.matchNumber());
+}
+
+void BookSet::onMessage(ITCH::BrokenTradeView const & m) {
+    if (feeds.trades) feeds.trades->breakTrade(m.timestamp(), m.stockLocate(), m.matchNumber());
+}
+
+#if FLAT_ORDER_INDEX
+// messages that act on a resting order
+static bool referencesOrder(ITCH::MessageType_t messageType) {
+    switch (messageType) {
+        case ITCH::OrderExecutedMessageType:
+        case ITCH::OrderExecutedWithPriceMessageType:
+        case ITCH::OrderCancelMessageType:
+        case ITCH::OrderDeleteMessageType:
+        case ITCH::OrderReplaceMessageType:
+            return true;
+        default:
+            return false;
+    }
+}
+#endif
+
+/*
+ * Every dependent load of a message (book -> index entry -> Order -> Level) misses on its own,
+ * one message at a time each miss stalls the loop
+ * With FLAT_ORDER_INDEX walk the batch once to prefetch the index slots, whose addresses follow
+ * from the reference numbers, and again to prefetch the Orders they point to, so the misses of
+ * different messages overlap, then apply the messages in order
+ * A hash bucket or a Level is only found by the lookup the message itself does, prefetching it
+ * would take the same miss synchronously, so the dense_hash_map build just applies the batch
+ * Prefetching only reads the books, so the batch is applied exactly as if message by message
+ */
+void BookSet::handleBatch(char const * const * messages, size_t count) {
+#if FLAT_ORDER_INDEX
+    for (size_t i = 0; i < count; ++i) {
+        char const * const m = messages[i];
+        if (!referencesOrder(ITCH::Parser::getDataMessageType(m))) continue;
+        OrderBook const * const book = peek(ITCH::Parser::getDataStockLocate(m));
+        if (book) book->prefetchIndex(ITCH::Parser::getDataOrderReferenceNumber(m));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        char const * const m = messages[i];
+        if (!referencesOrder(ITCH::Parser::getDataMessageType(m))) continue;
+        OrderBook const * const book = peek(ITCH::Parser::getDataStockLocate(m));
+        if (book) book->prefetchOrder(ITCH::Parser::getDataOrderReferenceNumber(m));
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        apply(messages[i]);
+    }
+    if (feeds.bbo && feeds.bbo->conflation() == BboTape::Conflation::BATCH) publishBbo();
+}
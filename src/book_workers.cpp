@@ -0,0 +1,109 @@
+#include "book_workers.hpp"
+#include "itch_reader.hpp"
+#include <algorithm>
+#include <cstring>                  // memcpy
+#include <pthread.h>                // pthread_setaffinity_np
+#include <sched.h>                  // CPU_SET
+#include <immintrin.h>              // _mm_pause
+
+// busy wait this many times before yielding the core
+static constexpr unsigned SPIN_LIMIT = 1024;
+
+static void backoff(unsigned & spins) {
+    if (++spins < SPIN_LIMIT) _mm_pause();
+    else std::this_thread::yield();
+}
+
+BookWorkers::BookWorkers(size_t threads, BookPools::Config const & config, BookFeeds const * feeds, SnapshotReader const * _snapshot, SymbolFilter const * _symbols) :
+    snapshot(_snapshot),
+    symbols(_symbols),
+    restoring(_snapshot ? threads : 0),
+    done(false) {
+    // cpu 0 is left to the reading thread
+    size_t const cpus = std::max(1u, std::thread::hardware_concurrency());
+    BookPools::Config workerConfig = config;
+    workerConfig.reserveOrders /= threads;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>(workerConfig, feeds ? feeds[i] : BookFeeds()));
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread(&BookWorkers::run, this, std::ref(*workers[i]), i, (i + 1) % cpus);
+    }
+}
+
+BookWorkers::~BookWorkers() {
+    finish();
+}
+
+void BookWorkers::handleMessage(char const * messageData) {
+    // skipped as MessageBatch skips it, before a slot is claimed
+    if (!ITCH::MessageSlot::fits(messageData)) [[unlikely]] return;
+    Worker & worker = *workers[ITCH::Parser::getDataStockLocate(messageData) % workers.size()];
+    ITCH::MessageSlot * slot;
+    unsigned spins = 0;
+    while (!(slot = worker.ring.claim())) backoff(spins);
+    std::memcpy(slot->data, messageData, ITCH::messageHeaderLength + ITCH::Parser::getDataMessageLength(messageData));
+    worker.ring.publish();
+}
+
+void BookWorkers::drain() {
+    unsigned restoreSpins = 0;
+    while (restoring.load(std::memory_order_acquire)) backoff(restoreSpins);
+    for (auto const & worker : workers) {
+        unsigned spins = 0;
+        while (!worker->ring.empty()) backoff(spins);
+    }
+}
+
+void BookWorkers::writeSnapshot(SnapshotWriter & out) {
+    drain();
+    for (auto const & worker : workers) worker->books.writeSnapshot(out);
+}
+
+void BookWorkers::finish() {
+    if (done.exchange(true, std::memory_order_acq_rel)) return;
+    for (auto const & worker : workers) {
+        worker->thread.join();
+    }
+}
+
+PathCounters BookWorkers::pathCounters() const {
+    PathCounters counters;
+    for (auto const & worker : workers) counters += worker->books.pathCounters();
+    return counters;
+}
+
+void BookWorkers::run(Worker & worker, size_t index, size_t cpu) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    // best effort, fails in restricted environments
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+
+    // with FLAT_ORDER_INDEX the orders must be indexed from this thread, messages queue up meanwhile
+    if (snapshot) {
+        size_t const shards = workers.size();
+        worker.books.restore(*snapshot, [this, index, shards](uint16_t stockLocate) {
+            return stockLocate % shards == index && (!symbols || symbols->subscribed(stockLocate));
+        });
+        restoring.fetch_sub(1, std::memory_order_release);
+    }
+
+    unsigned spins = 0;
+    while (true) {
+        ITCH::MessageSlot const * const slot = worker.ring.front();
+        if (slot) {
+            worker.books.handleMessage(slot->data);
+            // released only once applied, so an empty ring means the books are up to date
+            worker.ring.release();
+            spins = 0;
+        } else if (done.load(std::memory_order_acquire)) {
+            if (!worker.ring.front()) break;
+        } else {
+            backoff(spins);
+        }
+    }
+    // with FLAT_ORDER_INDEX books unindex their orders from this thread's index
+    worker.books.clear();
+}
@@ -0,0 +1,125 @@
+#include "chunk_stream.hpp"
+#include <algorithm>                // min
+#include <cstring>                  // memcpy
+#include <stdexcept>
+
+static_assert(ITCH::ChunkStream::PAD >= ITCH::messageHeaderLength + ITCH::maxITCHMessageSize);
+
+ITCH::ChunkStream::ChunkStream(size_t slotCount, size_t chunkBytes) :
+    bytesPerChunk(chunkBytes),
+    slots(slotCount),
+    released(0),
+    stopped(false),
+    failed(false),
+    current(0),
+    cursor(nullptr),
+    end(nullptr),
+    started(false),
+    finished(false),
+    bytesRead(0) {
+    if (slotCount < 2 || chunkBytes < PAD) throw std::invalid_argument("ChunkStream needs at least two chunks of PAD bytes");
+    for (Slot & slot : slots) slot.storage.resize(PAD + chunkBytes);
+    // an empty chunk until the first is read
+    cursor = end = slots[0].storage.data() + PAD;
+}
+
+char * ITCH::ChunkStream::acquire(uint64_t n) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this, n]() { return stopped || n < released + slots.size(); });
+    if (stopped) return nullptr;
+    return slots[n % slots.size()].storage.data() + PAD;
+}
+
+char * ITCH::ChunkStream::tryAcquire(uint64_t n) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopped || n >= released + slots.size()) return nullptr;
+    return slots[n % slots.size()].storage.data() + PAD;
+}
+
+void ITCH::ChunkStream::publish(uint64_t n, size_t bytes, bool last) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot & slot = slots[n % slots.size()];
+        slot.bytes = bytes;
+        slot.last = last;
+        slot.ready = n + 1;
+    }
+    changed.notify_all();
+}
+
+void ITCH::ChunkStream::fail(std::string const & what) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failed) failure = what;
+        failed = true;
+    }
+    changed.notify_all();
+}
+
+void ITCH::ChunkStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    changed.notify_all();
+}
+
+ITCH::ChunkStream::Slot & ITCH::ChunkStream::wait(uint64_t n) {
+    Slot & slot = slots[n % slots.size()];
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this, &slot, n]() { return failed || slot.ready == n + 1; });
+    // chunks published before the failure are still read
+    if (slot.ready != n + 1) throw std::runtime_error(failure);
+    return slot;
+}
+
+char const * ITCH::ChunkStream::nextChunk() {
+    while (true) {
+        if (cursor + messageHeaderLength <= end) {
+            uint16_t const messageLength = be16toh(*(uint16_t const *)cursor);
+            // 0 message size indicates end of session
+            if (!messageLength) return nullptr;
+            if (cursor + messageHeaderLength + messageLength <= end) return nextMessage();
+        }
+        // a truncated trailing message is dropped
+        if (!advance()) return nullptr;
+    }
+}
+
+bool ITCH::ChunkStream::advance() {
+    if (finished) return false;
+
+    // the head of a message cut off by the end of the chunk, it may itself sit in this chunk's pad
+    char carry[PAD];
+    size_t const carried = end - cursor;
+    if (carried >= PAD) throw std::runtime_error("Message longer than the longest ITCH message, not a BinaryFILE stream");
+    std::memcpy(carry, cursor, carried);
+
+    uint64_t const next = started ? current + 1 : 0;
+    Slot & slot = wait(next);
+    char * const data = slot.storage.data() + PAD;
+    std::memcpy(data - carried, carry, carried);
+    if (started) {
+        // the last message handed out was in the previous chunk, and is done with by now
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released = current + 1;
+        }
+        changed.notify_all();
+    }
+    started = true;
+    current = next;
+    cursor = data - carried;
+    end = data + slot.bytes;
+    finished = slot.last;
+    return true;
+}
+
+void ITCH::ChunkStream::skip(uint64_t bytes) {
+    while (bytes) {
+        if (cursor == end && !advance()) return;
+        size_t const n = std::min<uint64_t>(bytes, end - cursor);
+        cursor += n;
+        bytes -= n;
+    }
+}
@@ -0,0 +1,273 @@
+#include "compressed_reader.hpp"
+#include <algorithm>                // min, max
+#include <cstring>                  // memcpy
+#include <exception>
+#include <stdexcept>
+#include <fcntl.h>                  // open
+#include <unistd.h>                 // read
+#include <sys/mman.h>               // mmap, madvise
+#include <sys/stat.h>               // fstat
+#include <zlib.h>
+
+#if __has_include(<zstd.h>)
+#include <zstd.h>
+#define ZSTD_SUPPORT true
+#else
+#define ZSTD_SUPPORT false
+#endif
+
+namespace {
+
+constexpr unsigned char GZIP_MAGIC[] = {0x1f, 0x8b};
+constexpr unsigned char ZSTD_MAGIC[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+// decompresses the whole input, read() fills out and returns less than capacity only at the end
+class Decoder {
+public:
+    virtual ~Decoder() = default;
+    virtual size_t read(char * out, size_t capacity) = 0;
+};
+
+class RawDecoder : public Decoder {
+public:
+    RawDecoder(char const * _input, size_t _bytes) : input(_input), remaining(_bytes) {}
+    size_t read(char * out, size_t capacity) override {
+        size_t const n = std::min(capacity, remaining);
+        std::memcpy(out, input, n);
+        input += n;
+        remaining -= n;
+        return n;
+    }
+private:
+    char const *    input;
+    size_t          remaining;
+};
+
+class GzipDecoder : public Decoder {
+public:
+    GzipDecoder(char const * _input, size_t _bytes) : input(_input), remaining(_bytes), done(false) {
+        z = z_stream{};
+        // 32 accepts both gzip and zlib headers
+        if (inflateInit2(&z, 15 + 32) != Z_OK) throw std::runtime_error("Failed to start zlib");
+    }
+    ~GzipDecoder() override { inflateEnd(&z); }
+
+    size_t read(char * out, size_t capacity) override {
+        z.next_out = reinterpret_cast<Bytef *>(out);
+        z.avail_out = capacity;
+        while (z.avail_out && !done) {
+            if (!z.avail_in && remaining) {
+                // avail_in is 32 bits
+                size_t const n = std::min<size_t>(remaining, 1u << 30);
+                z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input));
+                z.avail_in = n;
+                input += n;
+                remaining -= n;
+            }
+            int const status = inflate(&z, Z_NO_FLUSH);
+            if (status == Z_STREAM_END) {
+                // a gzip file can hold several members, e.g. appended files or pigz output
+                if (!z.avail_in && !remaining) done = true;
+                else inflateReset(&z);
+            } else if (status == Z_BUF_ERROR) {
+                if (!z.avail_in && !remaining) throw std::runtime_error("Truncated gzip stream");
+            } else if (status != Z_OK) {
+                throw std::runtime_error(std::string("Corrupt gzip stream: ") + (z.msg ? z.msg : "unknown error"));
+            }
+        }
+        return capacity - z.avail_out;
+    }
+
+private:
+    z_stream        z;
+    char const *    input;
+    size_t          remaining;
+    bool            done;
+};
+
+#if ZSTD_SUPPORT
+class ZstdDecoder : public Decoder {
+public:
+    ZstdDecoder(char const * _input, size_t _bytes) : stream(ZSTD_createDStream()), in{_input, _bytes, 0}, done(false) {
+        if (!stream) throw std::runtime_error("Failed to start zstd");
+        ZSTD_initDStream(stream);
+    }
+    ~ZstdDecoder() override { ZSTD_freeDStream(stream); }
+
+    size_t read(char * out, size_t capacity) override {
+        ZSTD_outBuffer o{out, capacity, 0};
+        while (o.pos < o.size && !done) {
+            size_t const status = ZSTD_decompressStream(stream, &o, &in);
+            if (ZSTD_isError(status)) throw std::runtime_error(std::string("Corrupt zstd stream: ") + ZSTD_getErrorName(status));
+            // with room left in out, the decoder has flushed everything it has
+            if (in.pos == in.size && o.pos < o.size) {
+                if (status) throw std::runtime_error("Truncated zstd stream");
+                done = true;
+            }
+        }
+        return o.pos;
+    }
+
+private:
+    ZSTD_DStream *  stream;
+    ZSTD_inBuffer   in;
+    bool            done;
+};
+#endif
+
+} // namespace
+
+ITCH::CompressedReader::Format ITCH::CompressedReader::detect(char const * filename) {
+    int const fd = open(filename, O_RDONLY);
+    if (fd == -1) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    unsigned char magic[4] = {};
+    ssize_t const n = read(fd, magic, sizeof(magic));
+    close(fd);
+    if (n >= ssize_t(sizeof(GZIP_MAGIC)) && !std::memcmp(magic, GZIP_MAGIC, sizeof(GZIP_MAGIC))) return Format::GZIP;
+    if (n >= ssize_t(sizeof(ZSTD_MAGIC)) && !std::memcmp(magic, ZSTD_MAGIC, sizeof(ZSTD_MAGIC))) return Format::ZSTD;
+    // a BinaryFILE starts with a length prefix, which is never either
+    return Format::RAW;
+}
+
+ITCH::CompressedReader::CompressedReader(char const * _filename, uint64_t _startOffset, size_t decompressors)
+    : filename(_filename),
+    fileFormat(detect(_filename)),
+    input(nullptr),
+    inputBytes(0),
+    startOffset(_startOffset) {
+#if !ZSTD_SUPPORT
+    if (fileFormat == Format::ZSTD) throw std::invalid_argument(std::string("Built without zstd, cannot read: ") + _filename);
+#endif
+    int const fd = open(_filename, O_RDONLY);
+    if (fd == -1) throw std::invalid_argument(std::string("Failed to open file: ") + _filename);
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0) { close(fd); throw std::invalid_argument(std::string("Failed to read from file: ") + _filename); }
+    inputBytes = st.st_size;
+    void * const mapping = mmap(nullptr, inputBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) throw std::runtime_error(std::string("Failed to map file: ") + _filename);
+    input = static_cast<char const *>(mapping);
+    // hint only, compressed input is read once front to back
+    madvise(mapping, inputBytes, MADV_SEQUENTIAL);
+
+    if (fileFormat == Format::ZSTD && decompressors > 1) findFrames();
+
+    if (frames.empty()) {
+        stream = std::make_unique<ChunkStream>(CHUNKS, CHUNK_BYTES);
+        threads.emplace_back(&CompressedReader::decompressStream, this);
+    } else {
+        size_t largest = ChunkStream::PAD;
+        for (Frame const & frame : frames) largest = std::max(largest, frame.contentBytes);
+        size_t const count = std::min(decompressors, frames.size());
+        // a frame in flight on every thread and one more ready for each
+        stream = std::make_unique<ChunkStream>(std::max<size_t>(2, 2 * count), largest);
+        for (size_t i = 0; i < count; ++i) threads.emplace_back(&CompressedReader::decompressFrames, this, i, count);
+    }
+    try {
+        stream->skip(startOffset);
+    } catch (std::exception const &) {
+        shutdown();
+        throw;
+    }
+}
+
+ITCH::CompressedReader::~CompressedReader() {
+    shutdown();
+}
+
+void ITCH::CompressedReader::shutdown() {
+    stream->stop();
+    for (std::thread & thread : threads) thread.join();
+    threads.clear();
+    munmap(const_cast<char *>(input), inputBytes);
+}
+
+long long ITCH::CompressedReader::getTotalBytesRead() const {
+    return stream->getBytesRead();
+}
+
+uint64_t ITCH::CompressedReader::getOffset() const {
+    return startOffset + stream->getBytesRead();
+}
+
+void ITCH::CompressedReader::decompressStream() {
+    try {
+        std::unique_ptr<Decoder> decoder;
+        switch (fileFormat) {
+            case Format::GZIP:
+                decoder = std::make_unique<GzipDecoder>(input, inputBytes);
+                break;
+#if ZSTD_SUPPORT
+            case Format::ZSTD:
+                decoder = std::make_unique<ZstdDecoder>(input, inputBytes);
+                break;
+#endif
+            default:
+                decoder = std::make_unique<RawDecoder>(input, inputBytes);
+                break;
+        }
+        size_t const chunkBytes = stream->chunkBytes();
+        for (uint64_t n = 0; ; ++n) {
+            char * const data = stream->acquire(n);
+            if (!data) return;
+            size_t const bytes = decoder->read(data, chunkBytes);
+            bool const last = bytes < chunkBytes;
+            stream->publish(n, bytes, last);
+            if (last) return;
+        }
+    } catch (std::exception const & e) {
+        stream->fail(filename + ": " + e.what());
+    }
+}
+
+#if ZSTD_SUPPORT
+// frames are only worth splitting up if each one says how large it is, so its chunk can be sized up front
+void ITCH::CompressedReader::findFrames() {
+    char const * p = input;
+    size_t remaining = inputBytes;
+    while (remaining) {
+        size_t const bytes = ZSTD_findFrameCompressedSize(p, remaining);
+        // left for the streaming decoder to report
+        if (ZSTD_isError(bytes)) { frames.clear(); return; }
+        uint32_t magic;
+        std::memcpy(&magic, p, sizeof(magic));
+        // skippable frames, e.g. the seek table of the seekable format, hold no data
+        if ((magic & 0xFFFFFFF0u) != 0x184D2A50u) {
+            unsigned long long const contentBytes = ZSTD_getFrameContentSize(p, bytes);
+            if (contentBytes == ZSTD_CONTENTSIZE_UNKNOWN || contentBytes == ZSTD_CONTENTSIZE_ERROR || contentBytes > MAX_FRAME_BYTES) {
+                frames.clear();
+                return;
+            }
+            frames.push_back(Frame{p, bytes, size_t(contentBytes)});
+        }
+        p += bytes;
+        remaining -= bytes;
+    }
+    // one frame is no faster than streaming it
+    if (frames.size() < 2) frames.clear();
+}
+
+void ITCH::CompressedReader::decompressFrames(size_t first, size_t step) {
+    ZSTD_DCtx * const context = ZSTD_createDCtx();
+    try {
+        if (!context) throw std::runtime_error("Failed to start zstd");
+        for (size_t f = first; f < frames.size(); f += step) {
+            char * const data = stream->acquire(f);
+            if (!data) break;
+            size_t const bytes = ZSTD_decompressDCtx(context, data, stream->chunkBytes(), frames[f].data, frames[f].bytes);
+            if (ZSTD_isError(bytes)) throw std::runtime_error(std::string("Corrupt zstd frame: ") + ZSTD_getErrorName(bytes));
+            if (bytes != frames[f].contentBytes) throw std::runtime_error("zstd frame shorter than its header says");
+            stream->publish(f, bytes, f + 1 == frames.size());
+        }
+    } catch (std::exception const & e) {
+        stream->fail(filename + ": " + e.what());
+    }
+    ZSTD_freeDCtx(context);
+}
+#else
+void ITCH::CompressedReader::findFrames() {
+}
+
+void ITCH::CompressedReader::decompressFrames(size_t, size_t) {
+}
+#endif
@@ -0,0 +1,163 @@
+#include "itch_framer.hpp"
+#include "itch_common.hpp"
+#include <algorithm>                // min
+#include <cstring>                  // memcpy, memset
+#include <stdexcept>
+#include <string>
+#include <endian.h>                 // be16toh
+#include <immintrin.h>
+
+// offsets are gathered as signed 32 bit indices
+static constexpr size_t MAX_WINDOW_BYTES    = INT32_MAX - 64;
+static constexpr size_t VECTOR_BYTES        = 32;
+// type, locate, tracking number and timestamp, every message has at least these
+static constexpr size_t MIN_MESSAGE_LENGTH  = 11;
+
+ITCH::Framer::Framer(size_t maxMessages, bool useAVX2) :
+    capacity(maxMessages),
+    avx2(useAVX2 && hasAVX2()),
+    base(nullptr),
+    count(0),
+    ended(false),
+    offsets(maxMessages),
+    types(maxMessages + VECTOR_BYTES),
+    tablesBuilt(false) {
+}
+
+bool ITCH::Framer::hasAVX2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+size_t ITCH::Framer::frame(char const * begin, char const * end) {
+    end = begin + std::min<size_t>(end - begin, MAX_WINDOW_BYTES);
+    char const * p = begin;
+    size_t n = 0;
+    while (n < capacity && p + messageHeaderLength <= end) {
+        uint16_t length;
+        std::memcpy(&length, p, sizeof(length));
+        length = be16toh(length);
+        // a 0 length is the end of the session, as the readers treat it
+        if (!length) {
+            ended = true;
+            break;
+        }
+        if (length < MIN_MESSAGE_LENGTH) {
+            throw std::runtime_error("Message of " + std::to_string(length) + " bytes is shorter than a message header, at window offset " + std::to_string(p - begin));
+        }
+        char const * const next = p + messageHeaderLength + length;
+        if (next > end) break;
+        offsets[n++] = p - begin;
+        p = next;
+    }
+    base = begin;
+    count = n;
+    return p - begin;
+}
+
+void ITCH::Framer::gatherTypes() {
+    if (avx2) gatherTypesAVX2();
+    else gatherTypesScalar();
+}
+
+size_t ITCH::Framer::select(TypeSet const & set, std::vector<uint32_t> & indices) const {
+    indices.resize(count);
+    size_t const selected = avx2 ? selectAVX2(set, indices.data()) : selectScalar(set, indices.data());
+    indices.resize(selected);
+    return selected;
+}
+
+// 4 interleaved tables so consecutive equal types don't serialise on one counter
+void ITCH::Framer::countTypes(uint64_t (&counts)[256]) const {
+    uint64_t partial[4][256] = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        ++partial[0][static_cast<uint8_t>(types[i])];
+        ++partial[1][static_cast<uint8_t>(types[i + 1])];
+        ++partial[2][static_cast<uint8_t>(types[i + 2])];
+        ++partial[3][static_cast<uint8_t>(types[i + 3])];
+    }
+    for (; i < count; ++i) ++partial[0][static_cast<uint8_t>(types[i])];
+    for (size_t t = 0; t < 256; ++t) counts[t] = partial[0][t] + partial[1][t] + partial[2][t] + partial[3][t];
+}
+
+void ITCH::Framer::gatherTypesScalar() {
+    for (size_t i = 0; i < count; ++i) types[i] = base[offsets[i] + messageHeaderLength];
+    std::memset(types.data() + count, 0, VECTOR_BYTES);
+}
+
+size_t ITCH::Framer::selectScalar(TypeSet const & set, uint32_t * indices) const {
+    size_t selected = 0;
+    for (size_t i = 0; i < count; ++i) {
+        indices[selected] = i;
+        selected += set.contains(types[i]);
+    }
+    return selected;
+}
+
+// 8 offsets per gather, each lane loads the 4 bytes starting at a type byte
+// frame() only takes messages of at least MIN_MESSAGE_LENGTH bytes, so the load never leaves one
+__attribute__((target("avx2")))
+void ITCH::Framer::gatherTypesAVX2() {
+    int const * const typeBase = reinterpret_cast<int const *>(base + messageHeaderLength);
+    // byte 0 of each dword to the bottom of its 128 bit lane, then both lanes to the bottom 8 bytes
+    __m256i const pickLowBytes = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m256i const joinLanes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i const index = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&offsets[i]));
+        __m256i const words = _mm256_i32gather_epi32(typeBase, index, 1);
+        __m256i const packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(words, pickLowBytes), joinLanes);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(&types[i]), _mm256_castsi256_si128(packed));
+    }
+    for (; i < count; ++i) types[i] = base[offsets[i] + messageHeaderLength];
+    std::memset(types.data() + count, 0, VECTOR_BYTES);
+}
+
+// walking all 256 types costs as much as selecting a few hundred messages, so it is done once per set
+void ITCH::Framer::buildSelectTables(TypeSet const & set) const {
+    if (tablesBuilt && tableSet == set) return;
+    std::memset(lowHalf, 0, sizeof(lowHalf));
+    std::memset(highHalf, 0, sizeof(highHalf));
+    for (unsigned t = 0; t < 256; ++t) {
+        if (!set.contains(static_cast<MessageType_t>(t))) continue;
+        if (t < 128) lowHalf[t & 0xf] |= 1 << (t >> 4);
+        else highHalf[t & 0xf] |= 1 << ((t >> 4) - 8);
+    }
+    tableSet = set;
+    tablesBuilt = true;
+}
+
+// set membership of 32 type bytes at once from a 256 bit bitmap
+// the low nibble picks a byte of the bitmap column, the high nibble picks the bit in it
+__attribute__((target("avx2")))
+size_t ITCH::Framer::selectAVX2(TypeSet const & set, uint32_t * indices) const {
+    buildSelectTables(set);
+    __m256i const lowTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const *>(lowHalf)));
+    __m256i const highTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const *>(highHalf)));
+    __m256i const bitOf = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i const nibble = _mm256_set1_epi8(0xf);
+    __m256i const seven = _mm256_set1_epi8(7);
+
+    size_t selected = 0;
+    for (size_t i = 0; i < count; i += VECTOR_BYTES) {
+        __m256i const t = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&types[i]));
+        __m256i const lo = _mm256_and_si256(t, nibble);
+        __m256i const hi = _mm256_and_si256(_mm256_srli_epi16(t, 4), nibble);
+        __m256i const column = _mm256_blendv_epi8(
+            _mm256_shuffle_epi8(lowTable, lo),
+            _mm256_shuffle_epi8(highTable, lo),
+            _mm256_cmpgt_epi8(hi, seven));
+        __m256i const hit = _mm256_and_si256(column, _mm256_shuffle_epi8(bitOf, hi));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256())));
+        if (count - i < VECTOR_BYTES) mask &= (1U << (count - i)) - 1;
+        while (mask) {
+            indices[selected++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    return selected;
+}
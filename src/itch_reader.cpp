@@ -1,11 +1,15 @@
 #include "itch_reader.hpp"
 #include "itch_common.hpp"
+#include <algorithm>                // min
 #include <cstdlib>                  // strtoull
 #include <cstring>                  // memcpy
 #include <fcntl.h>                  // open
 #include <unistd.h>                 // read
+#include <sys/mman.h>               // mmap, madvise
+#include <sys/stat.h>               // fstat
 #include <endian.h>                 // be16toh
 #include <stdexcept>
+#include <string>
 
 #define ASSERT  false
 #if ASSERT
@@ -14,22 +18,33 @@
 
 static constexpr size_t MESSAGE_HEADER_LENGTH = 2;
 static constexpr size_t DEFAULT_BUFFER_SIZE   = 2048;
+static constexpr size_t ADVISE_WINDOW_SIZE    = 64 << 20;    // bytes of mapping to request ahead of the reader
+
+// the 6 byte timestamp at offset 5 of a message, read as exactly 6 bytes
+// a 12 byte message (System Event) ends one byte after it, possibly at the end of a mapping
+static uint64_t readTimestamp(char const * data) {
+    return uint64_t(be16toh(*(uint16_t *)(data + 5))) << 32 | be32toh(*(uint32_t *)(data + 7));
+}
 
 ITCH::Reader::Reader(char const * _filename) : Reader(_filename, DEFAULT_BUFFER_SIZE) {
 }
 
-ITCH::Reader::Reader(char const * _filename, size_t _bufferSize)
+ITCH::Reader::Reader(char const * _filename, size_t _bufferSize, uint64_t _startOffset)
     : fdItch(open(_filename, O_RDONLY)),
     bufferSize(_bufferSize),
     buffer(new char[_bufferSize]),
     _buffer(buffer),
     validBytes(0),
-    totalBytesRead(0) {
+    totalBytesRead(0),
+    startOffset(_startOffset) {
 #if ASSERT
     assert(bufferSize > MESSAGE_HEADER_LENGTH + maxITCHMessageSize);
 #endif
     if (fdItch == -1) { delete[] buffer; throw std::invalid_argument(std::string("Failed to open file: ") + _filename); }
-    if (read(fdItch, buffer, bufferSize) <= 0) { delete[] buffer; throw std::invalid_argument(std::string("Failed to read from file: ") + _filename); }
+    if (startOffset && lseek(fdItch, startOffset, SEEK_SET) == -1) { close(fdItch); delete[] buffer; throw std::invalid_argument(std::string("Failed to seek in file: ") + _filename); }
+    ssize_t const readBytes = read(fdItch, buffer, bufferSize);
+    if (readBytes <= 0) { close(fdItch); delete[] buffer; throw std::invalid_argument(std::string("Failed to read from file: ") + _filename); }
+    validBytes = readBytes;
 }
 
 ITCH::Reader::~Reader() {
@@ -37,48 +52,36 @@ ITCH::Reader::~Reader() {
     delete[] buffer;
 }
 
-char const * ITCH::Reader::nextMessage() {
-    // if entire buffer processed, perform read and reset _buffer
-    if (_buffer == (buffer + bufferSize)) {
-        ssize_t readBytes = read(fdItch, buffer, bufferSize);
-        if (readBytes <= 0) return nullptr;
-        validBytes = readBytes;
-        _buffer = buffer;
+// moves the unread tail of the buffer to its front and reads until it holds at least bytes, false at the end of the file
+bool ITCH::Reader::refill(size_t bytes) {
+    size_t const remaining = buffer + validBytes - _buffer;
+    std::memmove(buffer, _buffer, remaining);
+    _buffer = buffer;
+    validBytes = remaining;
+    while (validBytes < bytes) {
+        ssize_t const readBytes = read(fdItch, buffer + validBytes, bufferSize - validBytes);
+        if (readBytes == -1) throw std::runtime_error("Failed to read from file");
+        if (readBytes == 0) return false;
+        validBytes += readBytes;
     }
+    return true;
+}
 
-    // message header is 2 bytes
-    // if attempting to read header will go out of bounds
-    // copy first byte of header to beginning of buffer
-    // and fill in the remaining buffer bytes with a new read
-    if ((_buffer + MESSAGE_HEADER_LENGTH) > (buffer + bufferSize)) {
-        buffer[0] = *_buffer;
-        constexpr size_t remainingLength = 1;
-        ssize_t readBytes = read(fdItch, buffer + remainingLength, bufferSize - remainingLength);
-        if (readBytes <= 0) return nullptr;
-        validBytes = readBytes + remainingLength;
-        _buffer = buffer;
+char const * ITCH::Reader::nextMessage() {
+    // only the first validBytes of the buffer hold file data, the last read of a file is short
+    // a message header or message that runs past them is moved to the front and completed with a new read
+    // a truncated trailing message is dropped
+    if ((_buffer + MESSAGE_HEADER_LENGTH) > (buffer + validBytes)) {
+        if (!refill(MESSAGE_HEADER_LENGTH)) return nullptr;
     }
 
     // message header is 2 byte big endian number containing message length
     uint16_t messageLength = be16toh(*(uint16_t *)_buffer);
     // 0 message size indicates end of session
     if (messageLength == 0) return nullptr;
-    // handle case if current message is partial
-    // i.e. message extends past last byte in buffer
-    // copy current message to beginning of this buffer
-    // fill remaining buffer with read
-    // this will overflow if bufferSize > 2+messageLength, but this is already checked for in constructor
-    // update maxITCHMessageSize according to NASDAQ spec
-    if ((_buffer + MESSAGE_HEADER_LENGTH + messageLength) > (buffer + bufferSize)) {
-        size_t offset = (buffer + bufferSize - _buffer);    // length of partial message remaining in buffer
-        std::memcpy(buffer, _buffer, offset);               // copy length of partial message (offset) from end of _buffer to start of buffer
-        ssize_t readBytes = read(fdItch, buffer + offset, bufferSize - offset);
-        if (readBytes <= 0) {
-            if (readBytes == 0) return nullptr;
-            if (readBytes == -1) { delete[] buffer; throw std::runtime_error("Failed to read from file"); }
-        }
-        validBytes = readBytes + offset;
-        _buffer = buffer;
+    // bufferSize > MESSAGE_HEADER_LENGTH + maxITCHMessageSize, so any message fits once moved to the front
+    if ((_buffer + MESSAGE_HEADER_LENGTH + messageLength) > (buffer + validBytes)) {
+        if (!refill(MESSAGE_HEADER_LENGTH + messageLength)) return nullptr;
     }
 
 #if ASSERT
@@ -164,7 +167,7 @@ char const * ITCH::Reader::nextMessage() {
     totalBytesRead += (MESSAGE_HEADER_LENGTH + messageLength);
 
 #if ASSERT
-    assert(_buffer <= (buffer + bufferSize));
+    assert(_buffer <= (buffer + validBytes));
 #endif
 
     return out;
@@ -174,11 +177,221 @@ long long ITCH::Reader::getTotalBytesRead() const {
     return totalBytesRead;
 }
 
+uint64_t ITCH::Reader::getOffset() const {
+    return startOffset + totalBytesRead;
+}
+
+ITCH::MappedReader::MappedReader(char const * _filename, uint64_t startOffset)
+    : mappedBytes(0),
+    begin(nullptr),
+    start(nullptr),
+    end(nullptr),
+    _cursor(nullptr),
+    nextAdvise(nullptr),
+    advisedEnd(nullptr) {
+    int const fdItch = open(_filename, O_RDONLY);
+    if (fdItch == -1) throw std::invalid_argument(std::string("Failed to open file: ") + _filename);
+    struct stat st;
+    if (fstat(fdItch, &st) == -1 || st.st_size <= 0) { close(fdItch); throw std::invalid_argument(std::string("Failed to read from file: ") + _filename); }
+    mappedBytes = st.st_size;
+    void * const mapping = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fdItch, 0);
+    // mapping holds its own reference to the file
+    close(fdItch);
+    if (mapping == MAP_FAILED) throw std::runtime_error(std::string("Failed to map file: ") + _filename);
+
+    begin = static_cast<char const *>(mapping);
+    end = begin + mappedBytes;
+    start = begin + std::min<uint64_t>(startOffset, mappedBytes);
+    _cursor = start;
+    nextAdvise = start;
+    advisedEnd = start;
+
+    // hints only, failures are not fatal
+    // huge pages are only honoured for file mappings on some filesystems
+    madvise(mapping, mappedBytes, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(mapping, mappedBytes, MADV_HUGEPAGE);
+#endif
+    adviseNextWindow();
+}
+
+ITCH::MappedReader::~MappedReader() {
+    munmap(const_cast<char *>(begin), mappedBytes);
+}
+
+// request readahead one window at a time rather than the whole file
+// so a 10GB file does not evict everything else from the page cache
+void ITCH::MappedReader::adviseNextWindow() {
+    if (advisedEnd >= end) {
+        nextAdvise = end;   // never reached, nextMessage stops before end
+        return;
+    }
+    size_t const length = std::min<size_t>(ADVISE_WINDOW_SIZE, end - advisedEnd);
+    madvise(const_cast<char *>(advisedEnd), length, MADV_WILLNEED);
+    advisedEnd += length;
+    // request the following window once halfway through this one
+    nextAdvise = advisedEnd - length / 2;
+}
+
+char const * ITCH::MappedReader::nextMessage() {
+    // no chunk boundaries, only the end of the mapping needs checking
+    if ((_cursor + MESSAGE_HEADER_LENGTH) > end) return nullptr;
+
+    uint16_t messageLength = be16toh(*(uint16_t *)_cursor);
+    // 0 message size indicates end of session
+    if (messageLength == 0) return nullptr;
+    // truncated trailing message
+    if ((_cursor + MESSAGE_HEADER_LENGTH + messageLength) > end) [[unlikely]] return nullptr;
+
+    if (_cursor >= nextAdvise) [[unlikely]] adviseNextWindow();
+
+    char const *out = _cursor;
+    _cursor += (MESSAGE_HEADER_LENGTH + messageLength);
+    return out;
+}
+
+long long ITCH::MappedReader::getTotalBytesRead() const {
+    return _cursor - start;
+}
+
+uint64_t ITCH::MappedReader::getOffset() const {
+    return _cursor - begin;
+}
+
+ITCH::SystemEventMessage ITCH::Parser::createSystemEventMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    char messageType                = *data;
+    uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
+    uint16_t trackingNumber         = be16toh(*(uint16_t *)(data + 3));
+    uint64_t timestamp              = readTimestamp(data);
+    uint8_t eventCode               = *(data + 11);
+    return ITCH::SystemEventMessage{messageType, stockLocate, trackingNumber, timestamp, eventCode};
+}
+ITCH::StockDirectoryMessage ITCH::Parser::createStockDirectoryMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::StockDirectoryMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.marketCategory                = *(data + 19);
+    m.financialStatusIndicator      = *(data + 20);
+    m.roundLotSize                  = be32toh(*(uint32_t *)(data + 21));
+    m.roundLotsOnly                 = *(data + 25);
+    m.issueClassification           = *(data + 26);
+    std::memcpy(m.issueSubType, data + 27, sizeof(m.issueSubType));
+    m.authenticity                  = *(data + 29);
+    m.shortSaleThresholdIndicator   = *(data + 30);
+    m.IPOFlag                       = *(data + 31);
+    m.LULDReferencePriceTier        = *(data + 32);
+    m.ETPFlag                       = *(data + 33);
+    m.ETPLeverageFactor             = be32toh(*(uint32_t *)(data + 34));
+    m.inverseIndicator              = *(data + 38);
+    return m;
+}
+ITCH::StockTradingActionMessage ITCH::Parser::createStockTradingActionMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::StockTradingActionMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.tradingState                  = *(data + 19);
+    m.reserved                      = *(data + 20);
+    std::memcpy(m.reason, data + 21, sizeof(m.reason));
+    return m;
+}
+ITCH::RegSHORestrictionMessage ITCH::Parser::createRegSHORestrictionMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::RegSHORestrictionMessage m;
+    m.messageType                   = *data;
+    m.locateCode                    = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.RegSHOAction                  = *(data + 19);
+    return m;
+}
+ITCH::MarketParticipantPositionMessage ITCH::Parser::createMarketParticipantPositionMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::MarketParticipantPositionMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.MPID, data + 11, sizeof(m.MPID));
+    std::memcpy(m.stock, data + 15, sizeof(m.stock));
+    m.primaryMarketMaker            = *(data + 23);
+    m.marketMakerMode               = *(data + 24);
+    m.marketParticipantState        = *(data + 25);
+    return m;
+}
+ITCH::MWCBDeclineLevelMessage ITCH::Parser::createMWCBDeclineLevelMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    char messageType                = *data;
+    uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
+    uint16_t trackingNumber         = be16toh(*(uint16_t *)(data + 3));
+    uint64_t timestamp              = readTimestamp(data);
+    uint64_t level1                 = be64toh(*(uint64_t *)(data + 11));
+    uint64_t level2                 = be64toh(*(uint64_t *)(data + 19));
+    uint64_t level3                 = be64toh(*(uint64_t *)(data + 27));
+    return ITCH::MWCBDeclineLevelMessage{messageType, stockLocate, trackingNumber, timestamp, level1, level2, level3};
+}
+ITCH::MWCBStatusMessage ITCH::Parser::createMWCBStatusMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    char messageType                = *data;
+    uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
+    uint16_t trackingNumber         = be16toh(*(uint16_t *)(data + 3));
+    uint64_t timestamp              = readTimestamp(data);
+    uint8_t breachedLevel           = *(data + 11);
+    return ITCH::MWCBStatusMessage{messageType, stockLocate, trackingNumber, timestamp, breachedLevel};
+}
+ITCH::IPOQuotingPeriodUpdateMessage ITCH::Parser::createIPOQuotingPeriodUpdateMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::IPOQuotingPeriodUpdateMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.IPOQuotationReleaseTime       = be32toh(*(uint32_t *)(data + 19));
+    m.IPOQuotationReleaseQualifier  = *(data + 23);
+    m.IPOPrice                      = be32toh(*(uint32_t *)(data + 24));
+    return m;
+}
+ITCH::LULDAuctionCollarMessage ITCH::Parser::createLULDAuctionCollarMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::LULDAuctionCollarMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.auctionCollarReferencePrice   = be32toh(*(uint32_t *)(data + 19));
+    m.upperAuctionCollarPrice       = be32toh(*(uint32_t *)(data + 23));
+    m.lowerAuctionCollarPrice       = be32toh(*(uint32_t *)(data + 27));
+    m.auctionCollarExtension        = be32toh(*(uint32_t *)(data + 31));
+    return m;
+}
+ITCH::OperationalHaltMessage ITCH::Parser::createOperationalHaltMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::OperationalHaltMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.marketCode                    = *(data + 19);
+    m.operationalHaltAction         = *(data + 20);
+    return m;
+}
 ITCH::AddOrderMessage ITCH::Parser::createAddOrderMessage(char const * data) {
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     char side                       = *(data + 19);
     uint32_t shares                 = be32toh(*(uint32_t *)(data + 20));
@@ -189,7 +402,7 @@ ITCH::AddOrderMPIDAttributionMessage ITCH::Parser::createAddOrderMPIDAttribution
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     char side                       = *(data + 19);
     uint32_t shares                 = be32toh(*(uint32_t *)(data + 20));
@@ -200,7 +413,7 @@ ITCH::OrderExecutedMessage ITCH::Parser::createOrderExecutedMessage(char const *
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     uint32_t executedShares         = be32toh(*(uint32_t *)(data + 19));
     return ITCH::OrderExecutedMessage{messageType, stockLocate, timestamp, orderReferenceNumber, executedShares};
@@ -209,7 +422,7 @@ ITCH::OrderExecutedWithPriceMessage ITCH::Parser::createOrderExecutedWithPriceMe
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     uint32_t executedShares         = be32toh(*(uint32_t *)(data + 19));
     uint32_t executionPrice         = be32toh(*(uint32_t *)(data + 32));
@@ -219,7 +432,7 @@ ITCH::OrderCancelMessage ITCH::Parser::createOrderCancelMessage(char const * dat
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     uint32_t cancelledShares        = be32toh(*(uint32_t *)(data + 19));
     return ITCH::OrderCancelMessage{messageType, stockLocate, timestamp, orderReferenceNumber, cancelledShares};
@@ -228,7 +441,7 @@ ITCH::OrderDeleteMessage ITCH::Parser::createOrderDeleteMessage(char const * dat
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     return ITCH::OrderDeleteMessage{messageType, stockLocate, timestamp, orderReferenceNumber};
 }
@@ -236,7 +449,7 @@ ITCH::OrderReplaceMessage ITCH::Parser::createOrderReplaceMessage(char const * d
     data += MESSAGE_HEADER_LENGTH;
     char messageType                        = *data;
     uint16_t stockLocate                    = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp                      = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp                      = readTimestamp(data);
     uint64_t originalOrderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     uint64_t newOrderReferenceNumber        = be64toh(*(uint64_t *)(data + 19));
     uint32_t shares                         = be32toh(*(uint32_t *)(data + 27));
@@ -247,7 +460,7 @@ ITCH::TradeMessage ITCH::Parser::createTradeMessage(char const * data) {
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
     char side                       = *(data + 19);
     uint32_t shares                 = be32toh(*(uint32_t *)(data + 20));
@@ -258,29 +471,90 @@ ITCH::CrossTradeMessage ITCH::Parser::createCrossTradeMessage(char const * data)
     data += MESSAGE_HEADER_LENGTH;
     char messageType                = *data;
     uint16_t stockLocate            = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp              = be64toh(*(uint64_t *)(data + 5)) >> 16;
-    uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 11));
+    uint64_t timestamp              = readTimestamp(data);
     uint64_t shares                 = be64toh(*(uint64_t *)(data + 11));
     uint32_t crossPrice             = be32toh(*(uint32_t *)(data + 27));
+    uint64_t orderReferenceNumber   = be64toh(*(uint64_t *)(data + 31));    // match number, crosses have no order
     return ITCH::CrossTradeMessage{messageType, stockLocate, timestamp, orderReferenceNumber, shares, crossPrice};
 }
 ITCH::BrokenTradeMessage ITCH::Parser::createBrokenTradeMessage(char const * data) {
     data += MESSAGE_HEADER_LENGTH;
     char messageType        = *data;
     uint16_t stockLocate    = be16toh(*(uint16_t *)(data + 1));
-    uint64_t timestamp      = be64toh(*(uint64_t *)(data + 5)) >> 16;
+    uint64_t timestamp      = readTimestamp(data);
     uint64_t matchNumber    = be64toh(*(uint64_t *)(data + 11));
     return ITCH::BrokenTradeMessage{messageType, stockLocate, timestamp, matchNumber};
 }
 
+ITCH::NOIIMessage ITCH::Parser::createNOIIMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::NOIIMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    m.pairedShares                  = be64toh(*(uint64_t *)(data + 11));
+    m.imbalanceShares               = be64toh(*(uint64_t *)(data + 19));
+    m.imbalanceDirection            = *(data + 27);
+    std::memcpy(m.stock, data + 28, sizeof(m.stock));
+    m.farPrice                      = be32toh(*(uint32_t *)(data + 36));
+    m.nearPrice                     = be32toh(*(uint32_t *)(data + 40));
+    m.currentReferencePrice         = be32toh(*(uint32_t *)(data + 44));
+    m.crossType                     = *(data + 48);
+    m.priceVariationIndicator       = *(data + 49);
+    return m;
+}
+ITCH::RetailInterestMessage ITCH::Parser::createRetailInterestMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::RetailInterestMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.InterestFlag                  = *(data + 19);
+    return m;
+}
+ITCH::DirectListingWithCapitalRaisePriceDiscoveryMessage ITCH::Parser::createDirectListingWithCapitalRaisePriceDiscoveryMessage(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    ITCH::DirectListingWithCapitalRaisePriceDiscoveryMessage m;
+    m.messageType                   = *data;
+    m.stockLocate                   = be16toh(*(uint16_t *)(data + 1));
+    m.trackingNumber                = be16toh(*(uint16_t *)(data + 3));
+    m.timestamp                     = readTimestamp(data);
+    std::memcpy(m.stock, data + 11, sizeof(m.stock));
+    m.openEligibilityStatus         = *(data + 19);
+    m.minimumAllowablePrice         = be32toh(*(uint32_t *)(data + 20));
+    m.maximumAllowablePrice         = be32toh(*(uint32_t *)(data + 24));
+    m.nearExecutionPrice            = be32toh(*(uint32_t *)(data + 28));
+    m.nearExecutionTime             = be64toh(*(uint64_t *)(data + 32));
+    m.lowerPriceRangeCollar         = be32toh(*(uint32_t *)(data + 40));
+    m.upperPriceRangeCollar         = be32toh(*(uint32_t *)(data + 44));
+    return m;
+}
+
 ITCH::MessageType_t ITCH::Parser::getDataMessageType(char const * data) {
     data += MESSAGE_HEADER_LENGTH;
     return *data;
 }
 
+uint16_t ITCH::Parser::getDataMessageLength(char const * data) {
+    return be16toh(*(uint16_t *)data);
+}
+
+uint16_t ITCH::Parser::getDataStockLocate(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    return be16toh(*(uint16_t *)(data + 1));
+}
+
 ITCH::Timestamp_t ITCH::Parser::getDataTimestamp(char const * data) {
     data += MESSAGE_HEADER_LENGTH;
-    return be64toh(*(uint64_t *)(data + 5)) >> 16;
+    return readTimestamp(data);
+}
+
+uint64_t ITCH::Parser::getDataOrderReferenceNumber(char const * data) {
+    data += MESSAGE_HEADER_LENGTH;
+    return be64toh(*(uint64_t *)(data + 11));
 }
 
 ITCH::Timestamp_t ITCH::Parser::strToTimestamp(char const * timestampstr) {
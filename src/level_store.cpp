@@ -0,0 +1,234 @@
+#include "level_store.hpp"
+#include "order_book.hpp"
+#include "itch_common.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <glog/logging.h>
+
+LevelTree::LevelTree(char side) : isBid(side == ITCH::Side::BUY) {
+    levels.set_empty_key(0);
+    levels.set_deleted_key(-1);
+}
+
+void LevelTree::insert(Level * level) {
+    [[maybe_unused]] auto const levelRes = levels.insert(std::pair(level->price, level));
+    DLOG_ASSERT(levelRes.second);
+    [[maybe_unused]] auto const priceRes = sorted.insert(std::pair(level->price, level));
+    DLOG_ASSERT(priceRes.second);
+}
+
+void LevelTree::erase(uint32_t price) {
+    [[maybe_unused]] size_t levelEraseNum = levels.erase(price);
+    DLOG_ASSERT(levelEraseNum);
+    [[maybe_unused]] size_t priceEraseNum = sorted.erase(price);
+    DLOG_ASSERT(priceEraseNum);
+}
+
+Level * LevelTree::retire(Level * level) {
+    uint32_t const price = level->price;
+    [[maybe_unused]] size_t levelEraseNum = levels.erase(price);
+    DLOG_ASSERT(levelEraseNum);
+    Node node = sorted.extract(price);
+    DLOG_ASSERT(!node.empty());
+    return retired.push(price, level, std::move(node));
+}
+
+Level * LevelTree::revive(uint32_t price) {
+    Node node;
+    Level * const level = retired.take(price, node);
+    if (!level) return nullptr;
+    levels.insert(std::pair(price, level));
+    [[maybe_unused]] auto const priceRes = sorted.insert(std::move(node));
+    DLOG_ASSERT(priceRes.inserted);
+    return level;
+}
+
+void LevelTree::reset() {
+    DLOG_ASSERT(sorted.empty());
+    levels.clear_no_resize();
+}
+
+size_t LevelTree::depthOf(uint32_t price, size_t limit) const {
+    size_t depth = 0;
+    forEachWhile([&](Level const * level) {
+        if (depth == limit || (isBid ? level->price <= price : level->price >= price)) return false;
+        ++depth;
+        return true;
+    });
+    return depth;
+}
+
+Level * LevelTree::nth(size_t n) const {
+    Level * found = nullptr;
+    forEachWhile([&](Level * level) {
+        if (n--) return true;
+        found = level;
+        return false;
+    });
+    return found;
+}
+
+// baseTick starts so that every price wraps outside the window
+// i.e. nothing is placed until the first recentre allocates the slots
+LevelLadder::LevelLadder(char side) :
+    isBid(side == ITCH::Side::BUY),
+    tick(DEFAULT_TICK),
+    baseTick(-WINDOW_SLOTS),
+    bestSlot(NO_SLOT),
+    windowCount(0),
+    slots(nullptr),
+    occupied{}
+{}
+
+void LevelLadder::insert(Level * level) {
+    uint32_t const price = level->price;
+    uint32_t slot = slotOf(price);
+    if (slot == NO_SLOT) {
+        // touch moved out of a nearly empty window, slide the window to it
+        // out of a fuller one it overflows, spilling every window level to follow it would cost more than the tree
+        if (windowCount <= RECENTRE_THRESHOLD && (!windowCount || better(price, slotPrice(bestSlot)))) {
+            recentre(price);
+            slot = slotOf(price);
+        } else {
+            [[maybe_unused]] auto const res = overflow.insert(std::pair(price, level));
+            DLOG_ASSERT(res.second);
+            return;
+        }
+    }
+    DLOG_ASSERT(!slots[slot]);
+    slots[slot] = level;
+    occupied[slot / 64] |= (1ULL << (slot % 64));
+    if (!windowCount++ || better(price, slotPrice(bestSlot))) bestSlot = slot;
+}
+
+void LevelLadder::erase(uint32_t price) {
+    uint32_t const slot = slotOf(price);
+    if (slot == NO_SLOT) {
+        [[maybe_unused]] size_t eraseNum = overflow.erase(price);
+        DLOG_ASSERT(eraseNum);
+        return;
+    }
+    DLOG_ASSERT(slots[slot]);
+    slots[slot] = nullptr;
+    occupied[slot / 64] &= ~(1ULL << (slot % 64));
+    --windowCount;
+    if (windowCount) {
+        if (slot == bestSlot) bestSlot = nextWorse(slot);
+    } else {
+        bestSlot = NO_SLOT;
+        // window drained, move it to where the remaining levels are
+        if (!overflow.empty()) recentre(isBid ? overflow.rbegin()->first : overflow.begin()->first);
+    }
+}
+
+Level * LevelLadder::retire(Level * level) {
+    erase(level->price);
+    return retired.push(level->price, level, NoNode{});
+}
+
+Level * LevelLadder::revive(uint32_t price) {
+    NoNode node;
+    Level * const level = retired.take(price, node);
+    if (level) insert(level);
+    return level;
+}
+
+size_t LevelLadder::depthOf(uint32_t price, size_t limit) const {
+    uint32_t const slot = slotOf(price);
+    if (overflow.empty() && slot != NO_SLOT) return std::min(occupiedBetter(slot), limit);
+    size_t depth = 0;
+    forEachWhile([&](Level const * level) {
+        if (depth == limit || !better(level->price, price)) return false;
+        ++depth;
+        return true;
+    });
+    return depth;
+}
+
+Level * LevelLadder::nth(size_t n) const {
+    if (n >= size()) return nullptr;
+    Level * found = nullptr;
+    forEachWhile([&](Level * level) {
+        if (n--) return true;
+        found = level;
+        return false;
+    });
+    return found;
+}
+
+Level * LevelLadder::bestWithOverflow() const {
+    auto const & [overflowPrice, overflowLevel] = isBid ? *overflow.rbegin() : *overflow.begin();
+    if (windowCount && better(slotPrice(bestSlot), overflowPrice)) return slots[bestSlot];
+    return overflowLevel;
+}
+
+void LevelLadder::recentre(uint32_t price) {
+    if (!slots) slots.reset(new Level*[WINDOW_SLOTS]());
+
+    // spill what is left in the window
+    for (uint32_t slot = lowestAbove(-1); slot != NO_SLOT; slot = lowestAbove(slot)) {
+        overflow.insert(std::pair(slotPrice(slot), slots[slot]));
+        slots[slot] = nullptr;
+    }
+    for (uint64_t & word : occupied) word = 0;
+    windowCount = 0;
+    bestSlot = NO_SLOT;
+
+    // sub dollar names quote in $0.0001 increments
+    tick = price % DEFAULT_TICK ? SUBPENNY_TICK : DEFAULT_TICK;
+    uint32_t const priceTick = price / tick;
+    baseTick = priceTick > WINDOW_SLOTS / 2 ? priceTick - WINDOW_SLOTS / 2 : 0;
+
+    // pull in every overflow level that now fits
+    uint64_t const windowEnd = uint64_t(baseTick + WINDOW_SLOTS) * tick;
+    auto it = overflow.lower_bound(baseTick * tick);
+    while (it != overflow.end() && it->first < windowEnd) {
+        uint32_t const slot = slotOf(it->first);
+        if (slot == NO_SLOT) { ++it; continue; }
+        slots[slot] = it->second;
+        occupied[slot / 64] |= (1ULL << (slot % 64));
+        if (!windowCount++ || better(it->first, slotPrice(bestSlot))) bestSlot = slot;
+        it = overflow.erase(it);
+    }
+}
+
+uint32_t LevelLadder::highestBelow(uint32_t slot) const {
+    if (!slot) return NO_SLOT;
+    uint32_t const last = slot - 1;
+    uint32_t word = last / 64;
+    uint32_t const bit = last % 64;
+    uint64_t bits = occupied[word] & (bit == 63 ? ~0ULL : ((1ULL << (bit + 1)) - 1));
+    while (true) {
+        if (bits) return word * 64 + 63 - __builtin_clzll(bits);
+        if (!word) return NO_SLOT;
+        bits = occupied[--word];
+    }
+}
+
+uint32_t LevelLadder::lowestAbove(uint32_t slot) const {
+    uint32_t const first = slot + 1;    // -1 wraps to 0
+    if (first >= WINDOW_SLOTS) return NO_SLOT;
+    uint32_t word = first / 64;
+    uint64_t bits = occupied[word] & (~0ULL << (first % 64));
+    while (true) {
+        if (bits) return word * 64 + __builtin_ctzll(bits);
+        if (++word == WORDS) return NO_SLOT;
+        bits = occupied[word];
+    }
+}
+
+size_t LevelLadder::occupiedBetter(uint32_t slot) const {
+    size_t count = 0;
+    uint32_t const word = slot / 64;
+    uint32_t const bit = slot % 64;
+    if (isBid) {
+        // slots above
+        count += __builtin_popcountll(bit == 63 ? 0 : occupied[word] & (~0ULL << (bit + 1)));
+        for (uint32_t w = word + 1; w < WORDS; ++w) count += __builtin_popcountll(occupied[w]);
+    } else {
+        // slots below
+        count += __builtin_popcountll(occupied[word] & ((1ULL << bit) - 1));
+        for (uint32_t w = 0; w < word; ++w) count += __builtin_popcountll(occupied[w]);
+    }
+    return count;
+}
@@ -1,59 +1,122 @@
 #include "itch_common.hpp"
 #include "itch_reader.hpp"
+#include "compressed_reader.hpp"
+#include "prefetch_reader.hpp"
 #include "order_book.hpp"
+#include "book_set.hpp"
+#include "book_workers.hpp"
+#include "message_batch.hpp"
+#include "depth_feed.hpp"
+#include "bbo_tape.hpp"
+#include "trade_tape.hpp"
+#include "snapshot.hpp"
+#include "symbol_filter.hpp"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <boost/pool/object_pool.hpp>
-#include <sparsehash/dense_hash_map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <stdexcept>
+#include <cerrno>
+#include <unistd.h>                 // fork, _exit
+#include <sys/wait.h>               // waitpid
+#include <sys/stat.h>               // stat
 
+#ifndef BENCH
 #define BENCH false
-
-#if BENCH
-#include <chrono>
 #endif
 
-template <typename OStream>
-void showBooks(OStream& os, google::dense_hash_map<uint16_t, OrderBook*> const & books) {
+template <typename OStream, typename Books>
+void showBooks(OStream& os, Books & books) {
     const char * header = "address,referenceNumber,stockLocate,timestamp,side,shares,price,previous,next";
     os << header << std::endl;
-    for (const auto& [symbol, book] : books) {
-        os << *book << std::endl;
-    }
+    os << books;
 }
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " itch_filename [snapshot_timestamp...]" << std::endl;
-        std::cout << "\n" << "where" << '\n'
-            << "\t" << "itch_filename: a NasdaqTotalViewITCH file in BinaryFILE format" << '\n'
-            << "\t" << "snapshot_timestamp: time, in nanoseconds since midnight, at which to print a snapshot of the order book"
-            << std::endl;
-        return EXIT_FAILURE;
+// snapshots are CSV text (showBooks) or binary (snapshot.hpp), a binary one can be restored
+struct Snapshots {
+    bool                    binary  = false;
+    bool                    async   = false;    // written by a forked child, see BackgroundSnapshots
+    SnapshotReader const *  restore = nullptr;  // books to start from, the reader starts at its offset
+    uint64_t                fileBytes = 0;      // st_size of the ITCH file, recorded in binary snapshots
+};
+
+// Snapshots written off the replay path
+// the books are quiesced and fork()ed, the child writes its copy-on-write image of them and exits,
+// the parent goes straight back to applying messages and only pays for the fork and
+// the page faults of the first write to each page shared with a running child
+class BackgroundSnapshots {
+public:
+    BackgroundSnapshots() : forks(0), forkTime(0) {}
+    ~BackgroundSnapshots() { wait(); }
+
+    BackgroundSnapshots(BackgroundSnapshots const &)              = delete;
+    BackgroundSnapshots & operator=(BackgroundSnapshots const &)  = delete;
+
+    // write() runs in the child, which has no other threads, so it must not wait on any
+    template <typename F>
+    void run(F && write) {
+        reap(WNOHANG);
+        auto const t1 = std::chrono::steady_clock::now();
+        pid_t const pid = fork();
+        if (pid < 0) throw std::runtime_error(std::string("Failed to fork snapshot: ") + std::strerror(errno));
+        if (pid == 0) {
+            int status = 0;
+            try {
+                write();
+            } catch (std::exception const & e) {
+                std::cerr << e.what() << std::endl;
+                status = 1;
+            }
+            // skip destructors and atexit, the parent's buffers and files are not the child's to flush
+            _exit(status);
+        }
+        forkTime += std::chrono::steady_clock::now() - t1;
+        ++forks;
+        children.push_back(pid);
     }
 
-    char const * itchFilename = argv[1];
-#if BENCH
-    std::cout << "Processing " << itchFilename << std::endl;
-#endif
+    // wait for every snapshot still being written
+    void wait() { reap(0); }
 
-#if !BENCH
-    // store timestamp args in order
-    std::vector<ITCH::Timestamp_t> timestamps;
-    for (int i = 2; i < argc; ++i) {
-        timestamps.push_back(ITCH::Parser::strToTimestamp(argv[i]));
+    size_t count() const { return forks; }
+    // time the replay was paused for, the fork itself
+    std::chrono::nanoseconds paused() const { return forkTime; }
+
+private:
+    void reap(int options) {
+        std::erase_if(children, [options](pid_t pid) {
+            int status;
+            if (waitpid(pid, &status, options) == 0) return false;
+            if (!WIFEXITED(status) || WEXITSTATUS(status)) std::cerr << "snapshot " << pid << " failed" << std::endl;
+            return true;
+        });
     }
-    sort(timestamps.begin(),
-            timestamps.end(),
-            [](ITCH::Timestamp_t a, ITCH::Timestamp_t b) { return b < a; });
-#endif
 
-    ITCH::Reader reader(itchFilename, 16384);
-    boost::object_pool<OrderBook> booksmem;
-    google::dense_hash_map<uint16_t, OrderBook*> books;
-    books.set_empty_key(0);
-    books.set_deleted_key(-1);
+    std::vector<pid_t>          children;
+    size_t                      forks;
+    std::chrono::nanoseconds    forkTime;
+};
+
+// Books is either a BookSet built on this thread or BookWorkers
+// with batchSize > 0 messages are handed over batchSize at a time, see BookSet::handleBatch
+// with symbols only the messages it passes reach the books
+template <typename Reader, typename Books>
+void replay(Reader & reader, Books & books, size_t batchSize, SymbolFilter * symbols, [[maybe_unused]] Snapshots const & snapshots, [[maybe_unused]] char const * itchFilename, [[maybe_unused]] std::vector<ITCH::Timestamp_t> & timestamps) {
     char const * messageData;
+    [[maybe_unused]] uint64_t applied = snapshots.restore ? snapshots.restore->info().messages : 0;
+    [[maybe_unused]] BackgroundSnapshots background;
+    ITCH::MessageBatch batch(batchSize);
+    auto const flush = [&books, &batch]() {
+        books.handleBatch(batch.data(), batch.size());
+        batch.clear();
+    };
 
 #if BENCH
     using std::chrono::high_resolution_clock;
@@ -73,81 +136,343 @@ int main(int argc, char** argv) {
                 std::string snapshotFilename;
                 snapshotFilename.append(itchFilename);
                 snapshotFilename.append(std::to_string(nextCaptureTimestamp));
-                snapshotFilename.append(".csv");
-                std::ofstream os(snapshotFilename.c_str());
-                showBooks(os, books);
+                if (!batch.empty()) flush();
+                // resumes with the message that crossed the snapshot time
+                SnapshotInfo const info{reader.getOffset() - ITCH::messageHeaderLength - ITCH::Parser::getDataMessageLength(messageData), applied, nextCaptureTimestamp, snapshots.fileBytes};
+                snapshotFilename.append(snapshots.binary ? ".snap" : ".csv");
+                auto const write = [&books, &snapshots, &snapshotFilename, &info]() {
+                    if (snapshots.binary) {
+                        SnapshotWriter out(snapshotFilename.c_str(), info);
+                        books.writeSnapshot(out);
+                        out.finish();
+                    } else {
+                        std::ofstream os(snapshotFilename.c_str());
+                        showBooks(os, books);
+                    }
+                };
+                if (snapshots.async) {
+                    // workers must be idle when forked, the child only has this thread
+                    if constexpr (requires { books.drain(); }) books.drain();
+                    background.run(write);
+                } else {
+                    write();
+                }
                 timestamps.pop_back();
             }
         }
+        ++applied;
 #endif
 
-        ITCH::MessageType_t messageType = ITCH::Parser::getDataMessageType(messageData);
-        switch (messageType) {
-            [[likely]] case ITCH::AddOrderMessageType: {
-                ITCH::AddOrderMessage m = ITCH::Parser::createAddOrderMessage(messageData);
-                if (!books.count(m.stockLocate)) {
-                    OrderBook * const newBook = booksmem.construct();
-                    books.insert(std::pair(m.stockLocate, newBook));
-                }
-                books[m.stockLocate]->handleAddOrderMessage(m);
-                break;
-            }
-            [[unlikely]] case ITCH::AddOrderMPIDAttributionMessageType: {
-                ITCH::AddOrderMPIDAttributionMessage m = ITCH::Parser::createAddOrderMPIDAttributionMessage(messageData);
-                if (!books.count(m.stockLocate)) {
-                    OrderBook * const newBook = booksmem.construct();
-                    books.insert(std::pair(m.stockLocate, newBook));
-                }
-                books[m.stockLocate]->handleAddOrderMPIDAttributionMessage(m);
-                break;
-            }
-            case ITCH::OrderExecutedMessageType: {
-                ITCH::OrderExecutedMessage m = ITCH::Parser::createOrderExecutedMessage(messageData);
-                books[m.stockLocate]->handleOrderExecutedMessage(m);
-                break;
-            }
-            case ITCH::OrderExecutedWithPriceMessageType: {
-                ITCH::OrderExecutedWithPriceMessage m = ITCH::Parser::createOrderExecutedWithPriceMessage(messageData);
-                books[m.stockLocate]->handleOrderExecutedWithPriceMessage(m);
-                break;
-            }
-            case ITCH::OrderCancelMessageType: {
-                ITCH::OrderCancelMessage m = ITCH::Parser::createOrderCancelMessage(messageData);
-                books[m.stockLocate]->handleOrderCancelMessage(m);
-                if (!books[m.stockLocate]->orderCount()) {
-                    OrderBook * const removeBook = books.find(m.stockLocate)->second;
-                    books.erase(m.stockLocate);
-                    booksmem.destroy(removeBook);
-                }
-                break;
-            }
-            [[likely]] case ITCH::OrderDeleteMessageType: {
-                ITCH::OrderDeleteMessage m = ITCH::Parser::createOrderDeleteMessage(messageData);
-                books[m.stockLocate]->handleOrderDeleteMessage(m);
-                if (!books[m.stockLocate]->orderCount()) {
-                    OrderBook * const removeBook = books.find(m.stockLocate)->second;
-                    books.erase(m.stockLocate);
-                    booksmem.destroy(removeBook);
-                }
-                break;
-            }
-            case ITCH::OrderReplaceMessageType: {
-                ITCH::OrderReplaceMessage m = ITCH::Parser::createOrderReplaceMessage(messageData);
-                books[m.stockLocate]->handleOrderReplaceMessage(m);
-                break;
-            }
-            default: {
-                break;
-            }
-        };
+        if (!symbols || symbols->pass(messageData)) {
+            if (!batchSize) books.handleMessage(messageData);
+            else if (batch.push(messageData)) flush();
+        }
 #if BENCH
     ++messageCount;
 #endif
     }
+    if (!batch.empty()) flush();
+
+    if constexpr (requires { books.finish(); }) books.finish();
+
+#if !BENCH
+    if (background.count()) {
+        std::cerr << background.count() << " background snapshots, replay paused "
+            << background.paused().count() / 1000 / background.count() << " us per fork" << std::endl;
+    }
+#endif
 
 #if BENCH
     auto t2 = high_resolution_clock::now();
-    std::cout << "processed " << messageCount << " messages (" << reader.getTotalBytesRead()  << " bytes) in " << duration_cast<milliseconds>(t2 - t1).count() << " milliseconds" << std::endl;
+    auto const elapsed = duration_cast<milliseconds>(t2 - t1).count();
+    std::cout << books.pathCounters() << std::endl;
+    std::cout << "processed " << messageCount << " messages (" << reader.getTotalBytesRead()  << " bytes) in " << elapsed << " milliseconds";
+    if (elapsed) std::cout << " (" << reader.getTotalBytesRead() / 1000 / elapsed << " MB/s, " << messageCount / elapsed << "K messages/s)";
+    std::cout << std::endl;
+    if (messageCount) std::cout << "batch " << batchSize << ": " << duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / double(messageCount) << " ns/message" << std::endl;
 #endif
 }
 
+// a restored replay starts past the Stock Directory, so the subscribed locates are learnt from the head of the file
+template <typename Reader>
+void learnSymbols(Reader & reader, SymbolFilter & symbols, uint64_t endOffset) {
+    char const * messageData;
+    while (!symbols.complete() && reader.getOffset() < endOffset && (messageData = reader.nextMessage())) {
+        symbols.learn(messageData);
+    }
+}
+
+template <typename Reader>
+void replay(Reader & reader, size_t threads, size_t batchSize, SymbolFilter * symbols, BookPools::Config const & pools, std::vector<BookFeeds> const & feeds, Snapshots const & snapshots, char const * itchFilename, std::vector<ITCH::Timestamp_t> & timestamps) {
+    if (threads) {
+        BookWorkers books(threads, pools, feeds.data(), snapshots.restore, symbols);
+        replay(reader, books, batchSize, symbols, snapshots, itchFilename, timestamps);
+    } else {
+        BookSet books(pools, feeds[0]);
+        if (snapshots.restore) books.restore(*snapshots.restore, [symbols](uint16_t stockLocate) { return !symbols || symbols->subscribed(stockLocate); });
+        replay(reader, books, batchSize, symbols, snapshots, itchFilename, timestamps);
+    }
+}
+
+// stands in for a strategy process, keeps its own L2 from the depth feeds until the books are done
+class DepthConsumer {
+public:
+    DepthConsumer(std::vector<std::unique_ptr<DepthFeed>> const & _feeds, size_t levels) :
+        feeds(_feeds), depthBook(levels), updates(0), done(false), thread(&DepthConsumer::run, this) {}
+
+    // the books are done publishing, drain what is left
+    uint64_t finish() {
+        done.store(true, std::memory_order_release);
+        thread.join();
+        return updates;
+    }
+
+private:
+    void run() {
+        while (true) {
+            bool const finishing = done.load(std::memory_order_acquire);
+            bool polled = false;
+            DepthUpdate update;
+            for (auto const & feed : feeds) {
+                while (feed->poll(update)) {
+                    depthBook.apply(update);
+                    ++updates;
+                    polled = true;
+                }
+            }
+            if (finishing) break;
+            if (!polled) std::this_thread::yield();
+        }
+    }
+
+    std::vector<std::unique_ptr<DepthFeed>> const & feeds;
+    DepthBook           depthBook;
+    uint64_t            updates;
+    std::atomic<bool>   done;
+    std::thread         thread;
+};
+
+int main(int argc, char** argv) {
+    char const * itchFilename = nullptr;
+    char const * readerName = "mmap";
+    size_t decompressors = 1;
+    size_t threads = 0;
+    size_t batchSize = 0;
+    size_t depthLevels = 0;
+    char const * bboFilename = nullptr;
+    BboTape::Conflation bboConflation = BboTape::Conflation::TIMESTAMP;
+    char const * barsFilename = nullptr;
+    uint64_t barIntervalMs = 60000;
+    bool binarySnapshots = false;
+    bool asyncSnapshots = false;
+    char const * restoreFilename = nullptr;
+    std::vector<std::string> tickers;
+    BookPools::Config pools;
+    std::vector<ITCH::Timestamp_t> timestamps;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        if (!std::strcmp(argv[i], "--reader") && i + 1 < argc) {
+            readerName = argv[++i];
+            // a misspelt backend would otherwise be measured as another one
+            ok = !std::strcmp(readerName, "mmap") || !std::strcmp(readerName, "buffered")
+                || !std::strcmp(readerName, "prefetch") || !std::strcmp(readerName, "prefetch-thread");
+        } else if (!std::strcmp(argv[i], "--decompressors") && i + 1 < argc) {
+            decompressors = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) {
+            batchSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--depth") && i + 1 < argc) {
+            depthLevels = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--bbo") && i + 1 < argc) {
+            bboFilename = argv[++i];
+        } else if (!std::strcmp(argv[i], "--bbo-conflate") && i + 1 < argc) {
+            char const * const conflation = argv[++i];
+            ok = !std::strcmp(conflation, "timestamp") || !std::strcmp(conflation, "batch");
+            bboConflation = std::strcmp(conflation, "batch") ? BboTape::Conflation::TIMESTAMP : BboTape::Conflation::BATCH;
+        } else if (!std::strcmp(argv[i], "--bars") && i + 1 < argc) {
+            barsFilename = argv[++i];
+        } else if (!std::strcmp(argv[i], "--bar-interval-ms") && i + 1 < argc) {
+            barIntervalMs = std::max(1ull, std::strtoull(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(argv[i], "--binary-snapshots")) {
+            binarySnapshots = true;
+        } else if (!std::strcmp(argv[i], "--async-snapshots")) {
+            asyncSnapshots = true;
+        } else if (!std::strcmp(argv[i], "--restore") && i + 1 < argc) {
+            restoreFilename = argv[++i];
+        } else if (!std::strcmp(argv[i], "--symbols") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::parse(argv[++i]);
+            tickers.insert(tickers.end(), listed.begin(), listed.end());
+        } else if (!std::strcmp(argv[i], "--symbols-file") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::load(argv[++i]);
+            tickers.insert(tickers.end(), listed.begin(), listed.end());
+        } else if (!std::strcmp(argv[i], "--order-capacity") && i + 1 < argc) {
+            pools.orderCapacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--reserve-orders") && i + 1 < argc) {
+            pools.reserveOrders = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--huge-pages")) {
+            pools.hugePages = true;
+        } else if (argv[i][0] == '-') {
+            // an unknown option or one missing its value
+            ok = false;
+        } else if (!itchFilename) {
+            itchFilename = argv[i];
+        } else {
+            timestamps.push_back(ITCH::Parser::strToTimestamp(argv[i]));
+        }
+    }
+
+    if (!ok || !itchFilename) {
+        std::cout << "Usage: " << argv[0] << " [--reader mmap|buffered|prefetch|prefetch-thread] [--decompressors N] [--threads N] [--batch K] [--depth N] [--bbo tape_filename] [--bbo-conflate timestamp|batch] [--bars bars_filename] [--bar-interval-ms MS] [--binary-snapshots] [--async-snapshots] [--restore snapshot_filename] [--symbols TICKER,...] [--symbols-file filename] [--order-capacity N] [--reserve-orders N] [--huge-pages] itch_filename [snapshot_timestamp...]" << std::endl;
+        std::cout << "\n" << "where" << '\n'
+            << "\t" << "itch_filename: a NasdaqTotalViewITCH file in BinaryFILE format, optionally gzip or zstd compressed" << '\n'
+            << "\t" << "snapshot_timestamp: time, in nanoseconds since midnight, at which to print a snapshot of the order book" << '\n'
+            << "\t" << "--reader: read the file through a memory mapping (default), through a reused buffer, or ahead on an I/O thread (io_uring where available, or pread with prefetch-thread), compressed files are always decompressed ahead on other threads" << '\n'
+            << "\t" << "--decompressors: threads decompressing a zstd file of many frames, e.g. from pzstd (default 1)" << '\n'
+            << "\t" << "--threads: build books on N worker threads sharded by stock locate (default 0, build on the reading thread)" << '\n'
+            << "\t" << "--batch: apply messages K at a time, prefetching their orders with FLAT_ORDER_INDEX (default 0, one at a time)" << '\n'
+            << "\t" << "--depth: publish changes to the top N levels of every book to a consumer thread (default 0, off)" << '\n'
+            << "\t" << "--bbo: write every book's BBO (price, size, orders per side) to a binary tape each time it changes, one tape per worker thread" << '\n'
+            << "\t" << "--bbo-conflate: write a changed BBO at most once per timestamp (default) or per batch" << '\n'
+            << "\t" << "--bars: write OHLCV bars of every locate's printed trades to a binary file, corrected for broken trades, one file per worker thread" << '\n'
+            << "\t" << "--bar-interval-ms: bar length in milliseconds of market time (default 60000)" << '\n'
+            << "\t" << "--binary-snapshots: write snapshots as <itch_filename><timestamp>.snap, which --restore can load, instead of CSV" << '\n'
+            << "\t" << "--async-snapshots: write snapshots from a forked copy of the books while replay continues" << '\n'
+            << "\t" << "--restore: start from a binary snapshot of this itch_filename, replay resumes where it was taken" << '\n'
+            << "\t" << "--symbols: only build books for these tickers, every other locate is dropped as it is read" << '\n'
+            << "\t" << "--symbols-file: as --symbols, one ticker per line" << '\n'
+            << "\t" << "--order-capacity: most orders resting at once, per thread (default 2^28)" << '\n'
+            << "\t" << "--reserve-orders: commit memory for this many orders at startup, e.g. 140000000 for a full day" << '\n'
+            << "\t" << "--huge-pages: back the order and level pools with huge pages"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+#if BENCH
+    std::cout << "Using: " << (ITCH::CompressedReader::detect(itchFilename) != ITCH::CompressedReader::Format::RAW ? "decompressing" : readerName) << " reader" << std::endl;
+    std::cout << "Using: " << (LEVEL_LADDER ? "price ladder" : "std::map + google::dense_hash_map") << " levels" << std::endl;
+    std::cout << "Using: " << (FLAT_ORDER_INDEX ? "flat order index" : "google::dense_hash_map orders") << std::endl;
+    std::cout << "Using: " << threads << " worker threads" << std::endl;
+    std::cout << "Using: batches of " << batchSize << " messages" << std::endl;
+    std::cout << "Using: " << depthLevels << " depth feed levels" << std::endl;
+    std::cout << "Using: " << (bboFilename ? bboFilename : "no") << " BBO tape" << std::endl;
+    std::cout << "Using: " << (barsFilename ? barsFilename : "no") << " bars" << std::endl;
+    if (restoreFilename) std::cout << "Restoring " << restoreFilename << std::endl;
+    if (!tickers.empty()) std::cout << "Using: " << tickers.size() << " symbols" << std::endl;
+    std::cout << "Processing " << itchFilename << std::endl;
+#endif
+
+    // store timestamp args in order
+    sort(timestamps.begin(),
+            timestamps.end(),
+            [](ITCH::Timestamp_t a, ITCH::Timestamp_t b) { return b < a; });
+
+    struct stat st;
+    if (stat(itchFilename, &st) == -1) throw std::invalid_argument(std::string("Failed to open file: ") + itchFilename);
+    std::unique_ptr<SnapshotReader> restore;
+    if (restoreFilename) {
+        restore = std::make_unique<SnapshotReader>(restoreFilename);
+        // its offset points into the file it was taken from, anywhere else it lands mid-message
+        if (restore->info().fileBytes != uint64_t(st.st_size)) {
+            throw std::invalid_argument(std::string("Snapshot ") + restoreFilename + " was taken from another file than " + itchFilename
+                + " (" + std::to_string(restore->info().fileBytes) + " bytes, not " + std::to_string(st.st_size) + ")");
+        }
+        // books before the restored time are gone
+        while (!timestamps.empty() && timestamps.back() < restore->info().timestamp) {
+            std::cerr << "skipping snapshot at " << timestamps.back() << ", before the restored snapshot" << std::endl;
+            timestamps.pop_back();
+        }
+    }
+    Snapshots const snapshots{binarySnapshots, asyncSnapshots, restore.get(), uint64_t(st.st_size)};
+    uint64_t const startOffset = restore ? restore->info().offset : 0;
+
+    std::unique_ptr<SymbolFilter> symbols;
+    if (!tickers.empty()) {
+        symbols = std::make_unique<SymbolFilter>(tickers);
+        if (startOffset) {
+            if (ITCH::CompressedReader::detect(itchFilename) != ITCH::CompressedReader::Format::RAW) {
+                ITCH::CompressedReader head(itchFilename);
+                learnSymbols(head, *symbols, startOffset);
+            } else {
+                ITCH::MappedReader head(itchFilename);
+                learnSymbols(head, *symbols, startOffset);
+            }
+        }
+    }
+
+    // one feed per thread building books, each has a single producer
+    std::vector<std::unique_ptr<DepthFeed>> depthFeeds;
+    for (size_t i = 0; depthLevels && i < std::max<size_t>(threads, 1); ++i) {
+        depthFeeds.push_back(std::make_unique<DepthFeed>(depthLevels));
+    }
+    std::unique_ptr<DepthConsumer> depthConsumer;
+    if (depthLevels) depthConsumer = std::make_unique<DepthConsumer>(depthFeeds, depthLevels);
+    // one tape per thread building books, <bbo> or <bbo>.<worker>
+    std::vector<std::unique_ptr<BboTape>> bboTapes;
+    for (size_t i = 0; bboFilename && i < std::max<size_t>(threads, 1); ++i) {
+        std::string const tapeFilename = threads ? std::string(bboFilename) + "." + std::to_string(i) : std::string(bboFilename);
+        bboTapes.push_back(std::make_unique<BboTape>(tapeFilename.c_str(), bboConflation));
+    }
+    // one file per thread building books, <bars> or <bars>.<worker>
+    std::vector<std::unique_ptr<TradeTape>> tradeTapes;
+    for (size_t i = 0; barsFilename && i < std::max<size_t>(threads, 1); ++i) {
+        std::string const barsFile = threads ? std::string(barsFilename) + "." + std::to_string(i) : std::string(barsFilename);
+        tradeTapes.push_back(std::make_unique<TradeTape>(barsFile.c_str(), barIntervalMs * 1000000));
+    }
+    std::vector<BookFeeds> feeds(std::max<size_t>(threads, 1));
+    for (size_t i = 0; i < feeds.size(); ++i) {
+        if (depthLevels) feeds[i].depth = depthFeeds[i].get();
+        if (bboFilename) feeds[i].bbo = bboTapes[i].get();
+        if (barsFilename) feeds[i].trades = tradeTapes[i].get();
+    }
+
+    if (ITCH::CompressedReader::detect(itchFilename) != ITCH::CompressedReader::Format::RAW) {
+        ITCH::CompressedReader reader(itchFilename, startOffset, decompressors);
+        replay(reader, threads, batchSize, symbols.get(), pools, feeds, snapshots, itchFilename, timestamps);
+    } else if (!std::strcmp(readerName, "prefetch") || !std::strcmp(readerName, "prefetch-thread")) {
+        ITCH::PrefetchReader reader(itchFilename, startOffset, std::strcmp(readerName, "prefetch-thread") ? ITCH::PrefetchReader::Backend::AUTO : ITCH::PrefetchReader::Backend::THREAD);
+#if BENCH
+        std::cout << "Using: " << (reader.backend() == ITCH::PrefetchReader::Backend::URING ? "io_uring" : "pread thread") << " prefetch" << std::endl;
+#endif
+        replay(reader, threads, batchSize, symbols.get(), pools, feeds, snapshots, itchFilename, timestamps);
+    } else if (!std::strcmp(readerName, "buffered")) {
+        ITCH::Reader reader(itchFilename, 16384, startOffset);
+        replay(reader, threads, batchSize, symbols.get(), pools, feeds, snapshots, itchFilename, timestamps);
+    } else {
+        ITCH::MappedReader reader(itchFilename, startOffset);
+        replay(reader, threads, batchSize, symbols.get(), pools, feeds, snapshots, itchFilename, timestamps);
+    }
+
+    if (symbols) std::cerr << *symbols << std::endl;
+
+    // the books are done, so are their tapes
+    if (barsFilename) {
+        uint64_t records = 0, prints = 0, broken = 0, unmatched = 0;
+        for (auto const & tape : tradeTapes) {
+            tape->finish();
+            records += tape->records();
+            prints += tape->printCount();
+            broken += tape->brokenCount();
+            unmatched += tape->unmatchedCount();
+        }
+        std::cerr << "bars: " << records << " records of " << prints << " prints, " << broken << " broken";
+        if (unmatched) std::cerr << " (" << unmatched << " unknown match numbers)";
+        std::cerr << std::endl;
+    }
+
+    if (depthConsumer) {
+        [[maybe_unused]] uint64_t const updates = depthConsumer->finish();
+#if BENCH
+        uint64_t dropped = 0;
+        for (auto const & feed : depthFeeds) dropped += feed->dropped();
+        std::cout << "depth: " << updates << " updates, " << dropped << " dropped" << std::endl;
+#endif
+    }
+#if BENCH
+    if (bboFilename) {
+        uint64_t records = 0;
+        for (auto const & tape : bboTapes) records += tape->records();
+        std::cout << "bbo: " << records << " records" << std::endl;
+    }
+#endif
+}
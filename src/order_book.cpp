@@ -1,272 +1,529 @@
 #include "order_book.hpp"
 #include "itch_common.hpp"
 #include <cstdint>
-#include <tuple>
 #include <glog/logging.h>
 
 Level::Level(uint32_t _price) :
     price(_price),
     limitVolume(0),
-    first(nullptr),
-    last(nullptr)
+    first(0),
+    last(0)
 {}
 
-Order::Order(const std::tuple<uint64_t, uint16_t, uint64_t, char, uint32_t, uint32_t, Order*, Order*> & args) :
-    referenceNumber(std::get<0>(args)),
-    stockLocate(std::get<1>(args)),
-    timestamp(std::get<2>(args)),
-    side(std::get<3>(args)),
-    shares(std::get<4>(args)),
-    price(std::get<5>(args)),
-    prev(std::get<6>(args)),
-    next(std::get<7>(args))
+Order::Order(uint64_t _referenceNumber, uint16_t _stockLocate, uint64_t _timestamp, char _side, uint32_t _shares, uint32_t _price) :
+    shares(_shares),
+    price(_price),
+    buy(_side == ITCH::Side::BUY),
+    prev(0),
+    next(0),
+    referenceNumber(_referenceNumber),
+    timestamp(_timestamp),
+    stockLocate(_stockLocate)
 {}
 
-OrderBook::OrderBook() {
+#if FLAT_ORDER_INDEX
+// presized for a full day, ~140M orders + replaces
+thread_local OrderIndex OrderBook::orders(1ULL << 28);
+
+OrderBook::OrderBook(BookPools & _pools, DepthFeed * _depth) :
+    bids(ITCH::Side::BUY),
+    offers(ITCH::Side::SELL),
+    numOrders(0),
+    pools(_pools),
+    depth(_depth),
+    bbo{},
+    bboDirty(false),
+    lastExecutedPrice(0),
+    lastExecutedSize(0)
+{}
+
+Order * OrderBook::findOrder(uint64_t orderReferenceNumber) const {
+    return orders.find(orderReferenceNumber);
+}
+
+void OrderBook::indexOrder(Order * order) {
+    orders.insert(order->referenceNumber, order);
+    ++numOrders;
+}
+
+void OrderBook::unindexOrder(uint64_t orderReferenceNumber) {
+    orders.erase(orderReferenceNumber);
+    --numOrders;
+}
+
+size_t OrderBook::orderCount() const {
+    return numOrders;
+}
+
+// the shared index holds nothing of an empty book
+void OrderBook::resetIndex() {}
+
+void OrderBook::prefetchIndex(uint64_t orderReferenceNumber) const {
+    orders.prefetch(orderReferenceNumber);
+}
+
+// the slot prefetchIndex pulled in, so only the Order itself can miss
+void OrderBook::prefetchOrder(uint64_t orderReferenceNumber) const {
+    Order const * const o = orders.find(orderReferenceNumber);
+    if (o) __builtin_prefetch(o, 1);
+}
+#else
+OrderBook::OrderBook(BookPools & _pools, DepthFeed * _depth) :
+    bids(ITCH::Side::BUY),
+    offers(ITCH::Side::SELL),
+    pools(_pools),
+    depth(_depth),
+    bbo{},
+    bboDirty(false),
+    lastExecutedPrice(0),
+    lastExecutedSize(0) {
     orders.set_empty_key(0);
-    levelBids.set_empty_key(0);
-    levelOffers.set_empty_key(0);
     orders.set_deleted_key(-1);
-    levelBids.set_deleted_key(-1);
-    levelOffers.set_deleted_key(-1);
 }
 
+Order * OrderBook::findOrder(uint64_t orderReferenceNumber) const {
+    auto const it = orders.find(orderReferenceNumber);
+    return it != orders.end() ? it->second : nullptr;
+}
+
+void OrderBook::indexOrder(Order * order) {
+    [[maybe_unused]] auto const orderRes = orders.insert(std::pair(order->referenceNumber, order));
+    DLOG_ASSERT(orderRes.second);
+}
+
+void OrderBook::unindexOrder(uint64_t orderReferenceNumber) {
+    [[maybe_unused]] size_t orderEraseNum = orders.erase(orderReferenceNumber);
+    DLOG_ASSERT(orderEraseNum);
+}
+
+size_t OrderBook::orderCount() const {
+    return orders.size();
+}
+
+void OrderBook::resetIndex() {
+    // a long lived book's deletes leave the table full of tombstones
+    orders.clear_no_resize();
+}
+#endif
+
+void OrderBook::reset() {
+    DLOG_ASSERT(!orderCount());
+    resetIndex();
+    bids.reset();
+    offers.reset();
+    // the last delete left the quote empty, a bboChanged() still pending is left for the publisher
+    DLOG_ASSERT(bbo == BBO{});
+}
+
+// pools (and the flat index) outlive the book, hand back whatever is still resting
+OrderBook::~OrderBook() {
+    auto const releaseLevel = [this](Level * level) {
+        Order * o = pools.orders.at(level->first);
+        while (o) {
+            Order * const next = pools.orders.at(o->next);
+#if FLAT_ORDER_INDEX
+            orders.erase(o->referenceNumber);
+#endif
+            pools.orders.destroy(o);
+            o = next;
+        }
+        pools.levels.destroy(level);
+    };
+    bids.forEach(releaseLevel);
+    offers.forEach(releaseLevel);
+    auto const releaseRetired = [this](Level * level) { pools.levels.destroy(level); };
+    bids.forEachRetired(releaseRetired);
+    offers.forEachRetired(releaseRetired);
+}
+
+// struct and view handlers decode what they need and share these
+
 /*
  * Check if order already exists, do nothing and return if does
  * Construct order using mempool
  * addOrder()
  */
-void OrderBook::handleAddOrderMessage(ITCH::AddOrderMessage const & msg) {
-    DLOG(INFO) << msg;
-    DLOG_ASSERT(!orders.count(msg.orderReferenceNumber));
-    auto orderArgs = std::make_tuple(
-        msg.orderReferenceNumber,
-        msg.stockLocate,
-        msg.timestamp,
-        msg.buySellIndicator, 
-        msg.shares,
-        msg.price,
-        nullptr,
-        nullptr
-    );
+void OrderBook::add(uint64_t orderReferenceNumber, uint16_t stockLocate, uint64_t timestamp, char side, uint32_t shares, uint32_t price) {
+    DLOG_ASSERT(!findOrder(orderReferenceNumber));
     // construct Order in mempool
     // add Order* to unordered_map
-    Order * const newOrder = ordersmem.construct(orderArgs);
+    Order * const newOrder = pools.orders.construct(orderReferenceNumber, stockLocate, timestamp, side, shares, price);
     DLOG_ASSERT(newOrder);
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 0);
     addOrder(newOrder);
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 1);
+    DLOG_ASSERT(findOrder(newOrder->referenceNumber) == newOrder);
+}
+
+void OrderBook::execute(uint64_t orderReferenceNumber, uint32_t executedShares) {
+    Order * o = findOrder(orderReferenceNumber);
+    DLOG_ASSERT(o);
+    DLOG_ASSERT(executedShares <= o->shares);
+    lastExecutedPrice = o->price;
+    lastExecutedSize = executedShares;
+    if (o->shares == executedShares) {
+        DLOG(INFO) << "EXC filled order, deleting: " << *o;
+        deleteOrder(orderReferenceNumber);
+    } else {
+        o->shares -= executedShares;
+        auto & levels = o->buy ? bids : offers;
+        Level * const level = reducedLevel(levels, *o);
+        level->limitVolume -= executedShares;
+        quoteReduced(*o, executedShares);
+        if (depth) publishChange(levels, *level, *o);
+    }
+}
+
+void OrderBook::cancel(uint64_t orderReferenceNumber, uint32_t cancelledShares) {
+    Order * o = findOrder(orderReferenceNumber);
+    DLOG_ASSERT(o);
+    DLOG_ASSERT(cancelledShares < o->shares);
+    o->shares -= cancelledShares;
+    auto & levels = o->buy ? bids : offers;
+    Level * const level = reducedLevel(levels, *o);
+    level->limitVolume -= cancelledShares;
+    quoteReduced(*o, cancelledShares);
+    if (depth) publishChange(levels, *level, *o);
+}
+
+/*
+ * Replace in place
+ * the order keeps its pool slot and is re-keyed under its new reference number, it loses its time priority
+ * at the same price it is only moved to the back of its level, which is never emptied on the way
+ * at a new price it leaves its level, which is retired if emptied, and joins the new one
+ */
+void OrderBook::replace(uint64_t originalOrderReferenceNumber, uint64_t newOrderReferenceNumber, uint64_t timestamp, uint32_t shares, uint32_t price) {
+    Order * const o = findOrder(originalOrderReferenceNumber);
+    DLOG_ASSERT(o);
+    ++pools.counters.replaces;
+    unindexOrder(originalOrderReferenceNumber);
+    DLOG_ASSERT(!findOrder(newOrderReferenceNumber));
+
+    if (price == o->price) {
+        ++pools.counters.replacesInPlace;
+        auto & levels = o->buy ? bids : offers;
+        Level * const level = levels.find(price);
+        DLOG_ASSERT(level);
+        uint32_t const index = pools.orders.index(o);
+        if (level->last != index) {
+            if (o->prev) pools.orders.at(o->prev)->next = o->next;
+            else level->first = o->next;
+            pools.orders.at(o->next)->prev = o->prev;
+            pools.orders.at(level->last)->next = index;
+            o->prev = level->last;
+            o->next = 0;
+            level->last = index;
+        }
+        level->limitVolume = level->limitVolume - o->shares + shares;
+        o->referenceNumber = newOrderReferenceNumber;
+        o->timestamp = timestamp;
+        o->shares = shares;
+        indexOrder(o);
+        quoteResized(*level, *o);
+        if (depth) publishChange(levels, *level, *o);
+    } else {
+        unlinkOrder(o);
+        o->referenceNumber = newOrderReferenceNumber;
+        o->timestamp = timestamp;
+        o->shares = shares;
+        o->price = price;
+        o->prev = 0;
+        o->next = 0;
+        indexOrder(o);
+        linkOrder(o);
+    }
+    DLOG_ASSERT(findOrder(newOrderReferenceNumber) == o);
+}
+
+void OrderBook::handleAddOrderMessage(ITCH::AddOrderMessage const & msg) {
+    DLOG(INFO) << msg;
+    add(msg.orderReferenceNumber, msg.stockLocate, msg.timestamp, msg.buySellIndicator, msg.shares, msg.price);
 }
 
 void OrderBook::handleAddOrderMPIDAttributionMessage(ITCH::AddOrderMPIDAttributionMessage const & msg) {
     DLOG(INFO) << msg;
-    DLOG_ASSERT(!orders.count(msg.orderReferenceNumber));
-    auto orderArgs = std::make_tuple(
-        msg.orderReferenceNumber,
-        msg.stockLocate,
-        msg.timestamp,
-        msg.buySellIndicator,
-        msg.shares,
-        msg.price,
-        nullptr,
-        nullptr
-    );
-    // construct Order in mempool
-    // add Order* to unordered_map
-    Order * const newOrder = ordersmem.construct(orderArgs);
-    DLOG_ASSERT(newOrder);
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 0);
-    addOrder(newOrder);
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 1);
+    add(msg.orderReferenceNumber, msg.stockLocate, msg.timestamp, msg.buySellIndicator, msg.shares, msg.price);
 }
 
 void OrderBook::handleOrderExecutedMessage(ITCH::OrderExecutedMessage const & msg) {
     DLOG(INFO) << msg;
-    Order * o = orders.find(msg.orderReferenceNumber)->second;
-    DLOG_ASSERT(o);
-    DLOG_ASSERT(msg.executedShares <= o->shares);
-    if (o->shares == msg.executedShares) {
-        DLOG(INFO) << "EXC filled order, deleting: " << *o;
-        deleteOrder(msg.orderReferenceNumber);
-    } else {
-        o->shares -= msg.executedShares;
-        auto & levels = o->side == ITCH::Side::BUY ? levelBids : levelOffers;
-        levels[o->price]->limitVolume -= msg.executedShares;
-    }
+    execute(msg.orderReferenceNumber, msg.executedShares);
 }
 
 void OrderBook::handleOrderExecutedWithPriceMessage(ITCH::OrderExecutedWithPriceMessage const & msg) {
     DLOG(INFO) << msg;
-    Order * o = orders.find(msg.orderReferenceNumber)->second;
-    DLOG_ASSERT(o);
-    DLOG_ASSERT(msg.executedShares <= o->shares);
-    if (o->shares == msg.executedShares) {
-        DLOG(INFO) << "EXP filled order, deleting: " << *o;
-        deleteOrder(msg.orderReferenceNumber);
-    } else {
-        o->shares -= msg.executedShares;
-        auto & levels = o->side == ITCH::Side::BUY ? levelBids : levelOffers;
-        levels[o->price]->limitVolume -= msg.executedShares;
-    }
+    execute(msg.orderReferenceNumber, msg.executedShares);
+    // away from the order's limit, e.g. in a cross
+    lastExecutedPrice = msg.executionPrice;
 }
 
 void OrderBook::handleOrderCancelMessage(ITCH::OrderCancelMessage const & msg) {
     DLOG(INFO) << msg;
-    Order * o = orders.find(msg.orderReferenceNumber)->second;
-    DLOG_ASSERT(o);
-    DLOG_ASSERT(msg.cancelledShares < o->shares);
-    o->shares -= msg.cancelledShares;
-    auto & levels = o->side == ITCH::Side::BUY ? levelBids : levelOffers;
-    levels[o->price]->limitVolume -= msg.cancelledShares;
+    cancel(msg.orderReferenceNumber, msg.cancelledShares);
 }
 
 void OrderBook::handleOrderDeleteMessage(ITCH::OrderDeleteMessage const & msg) {
     DLOG(INFO) << msg;
-    DLOG_ASSERT(orders.count(msg.orderReferenceNumber) == 1);
     deleteOrder(msg.orderReferenceNumber);
-    DLOG_ASSERT(orders.count(msg.orderReferenceNumber) == 0);
+    DLOG_ASSERT(!findOrder(msg.orderReferenceNumber));
 }
 
 void OrderBook::handleOrderReplaceMessage(ITCH::OrderReplaceMessage const & msg) {
     DLOG(INFO) << msg;
-    DLOG_ASSERT(orders.count(msg.originalOrderReferenceNumber));
-    Order const * oldOrder = orders.find(msg.originalOrderReferenceNumber)->second;
-    DLOG_ASSERT(oldOrder);
-    auto orderArgs = std::make_tuple(
-        msg.newOrderReferenceNumber,
-        oldOrder->stockLocate,
-        msg.timestamp,
-        oldOrder->side,
-        msg.shares,
-        msg.price,
-        nullptr,
-        nullptr
-        );
-
-    Order * const newOrder = ordersmem.construct(orderArgs);
-    DLOG_ASSERT(newOrder);
+    replace(msg.originalOrderReferenceNumber, msg.newOrderReferenceNumber, msg.timestamp, msg.shares, msg.price);
+}
 
-    DLOG_ASSERT(orders.count(msg.originalOrderReferenceNumber) == 1);
-    deleteOrder(msg.originalOrderReferenceNumber);
-    DLOG_ASSERT(orders.count(msg.originalOrderReferenceNumber) == 0);
+void OrderBook::handleAddOrderMessage(ITCH::AddOrderView const & view) {
+    add(view.orderReferenceNumber(), view.stockLocate(), view.timestamp(), view.buySellIndicator(), view.shares(), view.price());
+}
 
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 0);
-    addOrder(newOrder);
-    DLOG_ASSERT(orders.count(newOrder->referenceNumber) == 1);
+void OrderBook::handleAddOrderMPIDAttributionMessage(ITCH::AddOrderMPIDAttributionView const & view) {
+    add(view.orderReferenceNumber(), view.stockLocate(), view.timestamp(), view.buySellIndicator(), view.shares(), view.price());
+}
+
+void OrderBook::handleOrderExecutedMessage(ITCH::OrderExecutedView const & view) {
+    execute(view.orderReferenceNumber(), view.executedShares());
+}
+
+void OrderBook::handleOrderExecutedWithPriceMessage(ITCH::OrderExecutedWithPriceView const & view) {
+    execute(view.orderReferenceNumber(), view.executedShares());
+    lastExecutedPrice = view.executionPrice();
+}
+
+void OrderBook::handleOrderCancelMessage(ITCH::OrderCancelView const & view) {
+    cancel(view.orderReferenceNumber(), view.cancelledShares());
+}
+
+void OrderBook::handleOrderDeleteMessage(ITCH::OrderDeleteView const & view) {
+    deleteOrder(view.orderReferenceNumber());
+}
+
+void OrderBook::handleOrderReplaceMessage(ITCH::OrderReplaceView const & view) {
+    replace(view.originalOrderReferenceNumber(), view.newOrderReferenceNumber(), view.timestamp(), view.shares(), view.price());
 }
 
 void OrderBook::addOrder(Order* newOrder) {
     DLOG(INFO) << "ADD adding order " << *newOrder;
-    DLOG_ASSERT(newOrder->side == ITCH::Side::BUY || newOrder->side == ITCH::Side::SELL);
     // add order to id,order map
-    [[maybe_unused]] auto const orderRes = orders.insert(std::pair(newOrder->referenceNumber, newOrder));
-    DLOG_ASSERT(orderRes.second);
-    auto & levels = newOrder->side == ITCH::Side::BUY ? levelBids : levelOffers;
+    indexOrder(newOrder);
+    linkOrder(newOrder);
+}
+
+void OrderBook::linkOrder(Order* newOrder) {
+    uint32_t const newIndex = pools.orders.index(newOrder);
+    auto & levels = newOrder->buy ? bids : offers;
+    Level * const orderLevel = levels.find(newOrder->price);
     // create level if doesnt exist
-    if (!levels.count(newOrder->price)) {
-        // add level to mempool
-        Level * const newLevel = levelsmem.construct(newOrder->price);
-        DLOG_ASSERT(newLevel);
-        // insert into price,level map
-        [[maybe_unused]] auto const levelRes = levels.insert(std::pair(newLevel->price, newLevel));
-        DLOG_ASSERT(levelRes.second);
-
-        // insert level into corresponding bid/ask tree
-        auto & targetMap = newOrder->side == ITCH::Side::BUY
-            ? sortedBidLimits
-            : sortedOfferLimits;
-        [[maybe_unused]] auto const priceRes = targetMap.insert(std::pair(newLevel->price, newLevel));
-        DLOG_ASSERT(priceRes.second);
+    if (!orderLevel) {
+        // a level emptied at this price a moment ago is put back as it was
+        Level * newLevel = levels.revive(newOrder->price);
+        if (newLevel) {
+            ++pools.counters.levelsRevived;
+        } else {
+            // add level to mempool
+            newLevel = pools.levels.construct(static_cast<uint32_t>(newOrder->price));
+            DLOG_ASSERT(newLevel);
+            // insert into price,level store
+            levels.insert(newLevel);
+        }
         DLOG(INFO) << "LVL added " << *newLevel;
         // if level is empty, inserted order is both first and last
-        newLevel->first = newOrder;
-        newLevel->last = newOrder;
-        newLevel->limitVolume += newOrder->shares;
+        newLevel->first = newIndex;
+        newLevel->last = newIndex;
+        newLevel->limitVolume = newOrder->shares;
+        quoteAdded(*newLevel, *newOrder, true);
+        if (depth) publishNew(levels, *newLevel, *newOrder);
         DLOG(INFO) << "ADD added order " << newOrder->referenceNumber << " to level " << newLevel;
     } else {
-        // get level for price and add order to end of level
-        Level * const orderLevel = levels.find(newOrder->price)->second;
-        DLOG_ASSERT(orderLevel);
         // otherwise just append and update last
-        orderLevel->last->next = newOrder;
+        pools.orders.at(orderLevel->last)->next = newIndex;
         newOrder->prev = orderLevel->last;
-        orderLevel->last = newOrder;
+        orderLevel->last = newIndex;
         orderLevel->limitVolume += newOrder->shares;
+        quoteAdded(*orderLevel, *newOrder, false);
+        if (depth) publishChange(levels, *orderLevel, *newOrder);
         DLOG(INFO) << "ADD added order " << newOrder->referenceNumber << " to level " << orderLevel;
     }
 }
 
 void OrderBook::deleteOrder(uint64_t orderReferenceNumber) {
     DLOG(INFO) << "DEL deleting order " << orderReferenceNumber;
-    DLOG_ASSERT(orders.count(orderReferenceNumber));
-    Order * const target = orders.find(orderReferenceNumber)->second;
+    Order * const target = findOrder(orderReferenceNumber);
     DLOG_ASSERT(target);
     // remove order from map
-    [[maybe_unused]] size_t orderEraseNum = orders.erase(orderReferenceNumber);
-    DLOG_ASSERT(orderEraseNum);
+    unindexOrder(orderReferenceNumber);
+    unlinkOrder(target);
+    pools.orders.destroy(target);
+}
 
+void OrderBook::unlinkOrder(Order * target) {
     // remove order from level list, connect remaining nodes
     if (target->prev) {
-        target->prev->next = target->next;
+        pools.orders.at(target->prev)->next = target->next;
     }
     if (target->next) {
-        target->next->prev = target->prev;
+        pools.orders.at(target->next)->prev = target->prev;
     }
 
-    auto & levels = target->side == ITCH::Side::BUY ? sortedBidLimits : sortedOfferLimits;
+    auto & levels = target->buy ? bids : offers;
     // remove from level pointers if first/last
     // TODO assert flag and handle with if
-    DLOG_ASSERT(levels.count(target->price));
-    Level * const level = levels.find(target->price)->second;
+    Level * const level = levels.find(target->price);
     DLOG_ASSERT(level);
     level->limitVolume -= target->shares;
-    DLOG_ASSERT(level);
-    if (level->first == target) {
+    uint32_t const targetIndex = pools.orders.index(target);
+    if (level->first == targetIndex) {
         level->first = target->next;
     }
-    if (level->last == target) {
+    if (level->last == targetIndex) {
         level->last = target->prev;
     }
-    // remove and destroy level if empty
-    // consider not destroying when empty, more memory but better performance if more orders with same price come in
+    // retire level if empty, it is only freed once enough other levels have emptied after it
     if (!level->limitVolume) {
-        DLOG(INFO) << "LVL deleting level " << level->price << " side " << target->side;
-        [[maybe_unused]] size_t levelEraseNum = levels.erase(level->price);
-        DLOG_ASSERT(levelEraseNum);
-        DLOG_ASSERT(target->side == ITCH::Side::BUY || target->side == ITCH::Side::SELL);
-        auto & targetMap = target->side == ITCH::Side::BUY
-            ? levelBids
-            : levelOffers;
-        DLOG(INFO) << "LVL deleting from map " << target->side << " " << target->price;
-        [[maybe_unused]] size_t priceEraseNum = targetMap.erase(level->price);
-        DLOG_ASSERT(priceEraseNum);
-        levelsmem.destroy(level);
+        DLOG(INFO) << "LVL retiring level " << level->price << " side " << target->side();
+        ++pools.counters.levelsEmptied;
+        size_t const levelDepth = depth ? levels.depthOf(level->price, depth->levels()) : 0;
+        Level * const evicted = levels.retire(level);
+        if (evicted) pools.levels.destroy(evicted);
+        quoteRemoved(levels, *target, true);
+        if (depth) publishDelete(levels, levelDepth, *target);
+    } else {
+        quoteRemoved(levels, *target, false);
+        if (depth) publishChange(levels, *level, *target);
+    }
+    DLOG(INFO) << "DEL unlinked order " << target->referenceNumber << " from level " << level;
+}
+
+// a partial execution or cancel is almost always at the touch, whose level is the cached best
+Level * OrderBook::reducedLevel(LevelStore const & levels, Order const & o) {
+    ++pools.counters.reductions;
+    Quote const & q = o.buy ? bbo.bid : bbo.ask;
+    if (q.orders && q.price == o.price) {
+        ++pools.counters.reductionsAtTouch;
+        return levels.best();
     }
-    DLOG(INFO) << "DEL deleted order " << target->referenceNumber << " from level " << level;
-    ordersmem.destroy(target);
+    return levels.find(o.price);
 }
 
+void OrderBook::writeSnapshot(SnapshotWriter & out, uint16_t stockLocate) const {
+    out.book(stockLocate, static_cast<uint32_t>(bids.size()), static_cast<uint32_t>(offers.size()));
+    auto const writeLevel = [this, &out](Level const * level) {
+        uint32_t orders = 0;
+        for (Order const * o = pools.orders.at(level->first); o; o = pools.orders.at(o->next)) ++orders;
+        out.level(level->price, orders);
+        for (Order const * o = pools.orders.at(level->first); o; o = pools.orders.at(o->next)) {
+            out.order(o->referenceNumber, o->timestamp, o->shares);
+        }
+    };
+    bids.forEach(writeLevel);
+    offers.forEach(writeLevel);
+}
+
+void OrderBook::restoreOrder(uint64_t orderReferenceNumber, uint16_t stockLocate, uint64_t timestamp, char side, uint32_t shares, uint32_t price) {
+    add(orderReferenceNumber, stockLocate, timestamp, side, shares, price);
+}
+
+/*
+ * BBO cache
+ * each side's quote follows its best level, Level has no order count so the touch counts its own
+ * only a removed best level costs more than a compare, the new best level's orders are counted once
+ */
+void OrderBook::quoteAdded(Level const & level, Order const & o, bool newLevel) {
+    Quote & q = o.buy ? bbo.bid : bbo.ask;
+    if (newLevel) {
+        if (q.orders && (o.buy ? level.price < q.price : level.price > q.price)) return;
+        q = Quote{level.price, level.limitVolume, 1};
+    } else {
+        if (level.price != q.price) return;
+        q.volume = level.limitVolume;
+        ++q.orders;
+    }
+    bboDirty = true;
+}
+
+void OrderBook::quoteReduced(Order const & o, uint32_t shares) {
+    Quote & q = o.buy ? bbo.bid : bbo.ask;
+    if (o.price != q.price || !q.orders) return;
+    q.volume -= shares;
+    bboDirty = true;
+}
+
+// o was replaced on its own level
+void OrderBook::quoteResized(Level const & level, Order const & o) {
+    Quote & q = o.buy ? bbo.bid : bbo.ask;
+    if (level.price != q.price || !q.orders) return;
+    q.volume = level.limitVolume;
+    bboDirty = true;
+}
+
+// o has already left its level
+void OrderBook::quoteRemoved(LevelStore const & levels, Order const & o, bool levelRemoved) {
+    Quote & q = o.buy ? bbo.bid : bbo.ask;
+    if (o.price != q.price || !q.orders) return;
+    bboDirty = true;
+    if (!levelRemoved) {
+        q.volume -= o.shares;
+        --q.orders;
+        return;
+    }
+    Level const * const best = levels.best();
+    if (!best) {
+        q = Quote{};
+        return;
+    }
+    q = Quote{best->price, best->limitVolume, 0};
+    for (Order const * b = pools.orders.at(best->first); b; b = pools.orders.at(b->next)) ++q.orders;
+}
+
+/*
+ * Depth feed
+ * a level's depth is the number of levels better than it, only the top depth->levels() are published
+ * once a level in the top N is gone the level below the window moves up into it and is sent as NEW
+ */
+void OrderBook::publishChange(LevelStore const & levels, Level const & level, Order const & o) {
+    size_t const n = depth->levels();
+    size_t const levelDepth = levels.depthOf(level.price, n);
+    if (levelDepth < n) {
+        depth->publish({static_cast<uint16_t>(o.stockLocate), o.side(), DepthUpdate::CHANGE, level.price, level.limitVolume, static_cast<uint32_t>(levelDepth)});
+    }
+}
+
+void OrderBook::publishNew(LevelStore const & levels, Level const & level, Order const & o) {
+    size_t const n = depth->levels();
+    size_t const levelDepth = levels.depthOf(level.price, n);
+    if (levelDepth < n) {
+        depth->publish({static_cast<uint16_t>(o.stockLocate), o.side(), DepthUpdate::NEW, level.price, level.limitVolume, static_cast<uint32_t>(levelDepth)});
+    }
+}
+
+void OrderBook::publishDelete(LevelStore const & levels, size_t levelDepth, Order const & o) {
+    size_t const n = depth->levels();
+    if (levelDepth >= n) return;
+    uint16_t const stockLocate = static_cast<uint16_t>(o.stockLocate);
+    depth->publish({stockLocate, o.side(), DepthUpdate::DELETE, o.price, 0, static_cast<uint32_t>(levelDepth)});
+    Level const * const refill = levels.nth(n - 1);
+    if (refill) {
+        depth->publish({stockLocate, o.side(), DepthUpdate::NEW, refill->price, refill->limitVolume, static_cast<uint32_t>(n - 1)});
+    }
+}
 
 uint32_t OrderBook::getLimitVolume(char side, uint32_t price) const {
-    auto const & levelSideMap = side == ITCH::Side::BUY ? levelBids : levelOffers;
-    Level const * level = levelSideMap.find(price)->second;
-    DLOG_ASSERT(level);
+    auto const & levels = side == ITCH::Side::BUY ? bids : offers;
+    Level const * level = levels.find(price);
     return level ? level->limitVolume : 0;
 }
 
 uint32_t OrderBook::getBestBid() const {
-    auto const & it = sortedBidLimits.rbegin();
-    return it != sortedBidLimits.rend() ? sortedBidLimits.rbegin()->second->price : 0;
+    DLOG_ASSERT(bbo.bid.price == (bids.best() ? bids.best()->price : 0));
+    return bbo.bid.price;
 }
 uint32_t OrderBook::getBestAsk() const {
-    auto const & it = sortedOfferLimits.begin();
-    return it != sortedOfferLimits.end() ? sortedOfferLimits.begin()->second->price : 0;
+    DLOG_ASSERT(bbo.ask.price == (offers.best() ? offers.best()->price : 0));
+    return bbo.ask.price;
 }
-/*
-uint32_t OrderBook::getLastExecutedPrice() const;
-uint32_t OrderBook::getLastExecutedSize() const;
-*/
 
-size_t OrderBook::orderCount() const {
-    return orders.size();
+uint32_t OrderBook::getLastExecutedPrice() const {
+    return lastExecutedPrice;
+}
+
+uint32_t OrderBook::getLastExecutedSize() const {
+    return lastExecutedSize;
 }
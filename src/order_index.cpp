@@ -0,0 +1,68 @@
+#include "order_index.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <glog/logging.h>
+
+OrderIndex::OrderIndex() : count(0) {
+    far.set_empty_key(0);
+    far.set_deleted_key(-1);
+}
+
+OrderIndex::OrderIndex(uint64_t expectedReferenceNumbers) : OrderIndex() {
+    pages.reserve(std::min(MAX_PAGES, (expectedReferenceNumbers >> PAGE_BITS) + 1));
+}
+
+OrderIndex::~OrderIndex() {
+    for (Page * p : pages) delete p;
+    for (Page * p : spare) delete p;
+}
+
+void OrderIndex::insert(uint64_t referenceNumber, Order * order) {
+    uint64_t const page = referenceNumber >> PAGE_BITS;
+    if (page >= MAX_PAGES) [[unlikely]] {
+        [[maybe_unused]] auto const res = far.insert(std::pair(referenceNumber, order));
+        DLOG_ASSERT(res.second);
+        ++count;
+        return;
+    }
+    if (page >= pages.size()) pages.resize(page + 1, nullptr);
+    Page * & p = pages[page];
+    if (!p) p = newPage();
+    DLOG_ASSERT(!p->slots[referenceNumber & PAGE_MASK]);
+    p->slots[referenceNumber & PAGE_MASK] = order;
+    ++p->live;
+    ++count;
+}
+
+void OrderIndex::erase(uint64_t referenceNumber) {
+    uint64_t const page = referenceNumber >> PAGE_BITS;
+    if (page >= pages.size()) [[unlikely]] {
+        [[maybe_unused]] size_t eraseNum = far.erase(referenceNumber);
+        DLOG_ASSERT(eraseNum);
+        --count;
+        return;
+    }
+    Page * & p = pages[page];
+    DLOG_ASSERT(p && p->slots[referenceNumber & PAGE_MASK]);
+    p->slots[referenceNumber & PAGE_MASK] = nullptr;
+    --count;
+    // every order in this page is gone, later reference numbers have moved on
+    if (!--p->live) {
+        if (spare.size() < SPARE_PAGES) spare.push_back(p);
+        else delete p;
+        p = nullptr;
+    }
+}
+
+Order * OrderIndex::findFar(uint64_t referenceNumber) const {
+    if (far.empty()) return nullptr;
+    auto const it = far.find(referenceNumber);
+    return it != far.end() ? it->second : nullptr;
+}
+
+OrderIndex::Page * OrderIndex::newPage() {
+    if (spare.empty()) return new Page();
+    Page * const p = spare.back();
+    spare.pop_back();
+    return p;
+}
@@ -0,0 +1,246 @@
+#include "prefetch_reader.hpp"
+#include <algorithm>                // min, max
+#include <cerrno>
+#include <cstring>                  // memset, strerror
+#include <exception>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>                  // open
+#include <unistd.h>                 // pread, syscall
+#include <sys/mman.h>               // mmap
+#include <sys/stat.h>               // fstat
+#include <sys/syscall.h>            // __NR_io_uring_*
+#include <sys/uio.h>                // iovec
+#include <linux/io_uring.h>
+
+// no liburing, the rings are mapped and driven directly
+struct ITCH::PrefetchReader::Uring {
+    explicit Uring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (fd < 0) throw std::runtime_error(std::string("io_uring unavailable: ") + std::strerror(errno));
+
+        sqBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool const single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqBytes = cqBytes = std::max(sqBytes, cqBytes);
+        sqRing = mmap(nullptr, sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing : mmap(nullptr, cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        void * const sqesMapping = mmap(nullptr, sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqesMapping == MAP_FAILED) {
+            release();
+            if (sqesMapping != MAP_FAILED) munmap(sqesMapping, sqesBytes);
+            throw std::runtime_error("Failed to map io_uring");
+        }
+        sqes = static_cast<io_uring_sqe *>(sqesMapping);
+
+        char * const sq = static_cast<char *>(sqRing);
+        sqTail  = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask  = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        char * const cq = static_cast<char *>(cqRing);
+        cqHead  = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail  = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask  = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes    = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        pending = 0;
+    }
+
+    ~Uring() {
+        munmap(sqes, sqesBytes);
+        release();
+    }
+
+    void release() {
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqBytes);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqBytes);
+        close(fd);
+    }
+
+    // queued until the next enter(), the iovec must stay valid until the read completes
+    void readv(int file, iovec * iov, uint64_t offset, uint64_t userData) {
+        unsigned const tail = *sqTail;
+        unsigned const index = tail & sqMask;
+        io_uring_sqe & sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = file;
+        sqe.addr = reinterpret_cast<uint64_t>(iov);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++pending;
+    }
+
+    // submits what is queued and waits for at least one completion
+    void enter() {
+        while (syscall(__NR_io_uring_enter, fd, pending, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+            if (errno != EINTR) throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+        }
+        pending = 0;
+    }
+
+    // f(userData, result) for each completion
+    template <typename F>
+    void reap(F && f) {
+        unsigned head = *cqHead;
+        unsigned const tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            io_uring_cqe const & cqe = cqes[head & cqMask];
+            f(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    int             fd;
+    void *          sqRing  = MAP_FAILED;
+    void *          cqRing  = MAP_FAILED;
+    size_t          sqBytes;
+    size_t          cqBytes;
+    size_t          sqesBytes;
+    io_uring_sqe *  sqes;
+    unsigned *      sqTail;
+    unsigned        sqMask;
+    unsigned *      sqArray;
+    unsigned *      cqHead;
+    unsigned *      cqTail;
+    unsigned        cqMask;
+    io_uring_cqe *  cqes;
+    unsigned        pending;
+};
+
+ITCH::PrefetchReader::PrefetchReader(char const * _filename, uint64_t _startOffset, Backend backend, size_t chunks)
+    : filename(_filename),
+    fd(open(_filename, O_RDONLY)),
+    startOffset(_startOffset),
+    fileBytes(0),
+    chunkCount(0),
+    io(backend),
+    stream(std::max<size_t>(2, chunks), CHUNK_BYTES) {
+    if (fd == -1) throw std::invalid_argument(std::string("Failed to open file: ") + _filename);
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0) { close(fd); throw std::invalid_argument(std::string("Failed to read from file: ") + _filename); }
+    fileBytes = uint64_t(st.st_size) > startOffset ? st.st_size - startOffset : 0;
+    chunkCount = std::max<uint64_t>(1, (fileBytes + CHUNK_BYTES - 1) / CHUNK_BYTES);
+    // hint only, the I/O thread reads front to back
+    posix_fadvise(fd, startOffset, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (io != Backend::THREAD) {
+        try {
+            ring = std::make_unique<Uring>(stream.slotCount());
+            io = Backend::URING;
+        } catch (std::runtime_error const &) {
+            if (io == Backend::URING) { close(fd); throw; }
+            io = Backend::THREAD;
+        }
+    }
+    thread = std::thread(io == Backend::URING ? &PrefetchReader::readUring : &PrefetchReader::readThread, this);
+}
+
+ITCH::PrefetchReader::~PrefetchReader() {
+    stream.stop();
+    thread.join();
+    ring.reset();
+    close(fd);
+}
+
+long long ITCH::PrefetchReader::getTotalBytesRead() const {
+    return stream.getBytesRead();
+}
+
+uint64_t ITCH::PrefetchReader::getOffset() const {
+    return startOffset + stream.getBytesRead();
+}
+
+size_t ITCH::PrefetchReader::chunkBytes(uint64_t n) const {
+    return std::min<uint64_t>(CHUNK_BYTES, fileBytes - std::min(fileBytes, n * CHUNK_BYTES));
+}
+
+void ITCH::PrefetchReader::readThread() {
+    for (uint64_t n = 0; n < chunkCount; ++n) {
+        char * const data = stream.acquire(n);
+        if (!data) return;
+        size_t const bytes = chunkBytes(n);
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t const r = pread(fd, data + done, bytes - done, startOffset + n * CHUNK_BYTES + done);
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) {
+                stream.fail(std::string("Failed to read from file: ") + filename);
+                return;
+            }
+            done += r;
+        }
+        stream.publish(n, bytes, n + 1 == chunkCount);
+    }
+}
+
+void ITCH::PrefetchReader::readUring() {
+    size_t const slots = stream.slotCount();
+    // per slot, what has been read of the chunk in it so far
+    std::vector<iovec> iov(slots);
+    std::vector<char *> data(slots);
+    std::vector<size_t> done(slots);
+    uint64_t next = 0;
+    size_t inflight = 0;
+    bool stopping = false;
+
+    auto const submit = [&](uint64_t n) {
+        size_t const slot = n % slots;
+        iov[slot].iov_base = data[slot] + done[slot];
+        iov[slot].iov_len = chunkBytes(n) - done[slot];
+        ring->readv(fd, &iov[slot], startOffset + n * CHUNK_BYTES + done[slot], n);
+    };
+
+    try {
+        while (true) {
+            // every free slot gets a read, only wait for one when nothing is in flight
+            while (!stopping && next < chunkCount && inflight < slots) {
+                char * const chunk = inflight ? stream.tryAcquire(next) : stream.acquire(next);
+                if (!chunk) break;
+                size_t const slot = next % slots;
+                data[slot] = chunk;
+                done[slot] = 0;
+                if (chunkBytes(next)) {
+                    submit(next);
+                    ++inflight;
+                } else {
+                    stream.publish(next, 0, next + 1 == chunkCount);
+                }
+                ++next;
+            }
+            // all read, or stopped with nothing left in flight
+            if (!inflight) return;
+
+            ring->enter();
+            ring->reap([&](uint64_t n, int result) {
+                size_t const slot = n % slots;
+                if (result == -EINTR || result == -EAGAIN) {
+                    submit(n);
+                    return;
+                }
+                if (result <= 0) {
+                    // the file shrank or the read failed, the slots still in flight are drained first
+                    if (!stopping) stream.fail(std::string("Failed to read from file: ") + filename + (result < 0 ? std::string(": ") + std::strerror(-result) : ""));
+                    stopping = true;
+                    --inflight;
+                    return;
+                }
+                done[slot] += result;
+                if (done[slot] < chunkBytes(n)) {
+                    submit(n);
+                    return;
+                }
+                stream.publish(n, done[slot], n + 1 == chunkCount);
+                --inflight;
+            });
+        }
+    } catch (std::exception const & e) {
+        // buffers may still be the target of reads, so they are never handed out again
+        stream.fail(filename + ": " + e.what());
+    }
+}
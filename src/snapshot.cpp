@@ -0,0 +1,92 @@
+#include "snapshot.hpp"
+#include <fcntl.h>                  // open
+#include <unistd.h>                 // close
+#include <sys/mman.h>               // mmap
+#include <sys/stat.h>               // fstat
+#include <stdexcept>
+#include <string>
+
+static constexpr char       MAGIC[8]        = {'O', 'B', 'S', 'N', 'A', 'P', 0, 0};
+static constexpr uint32_t   VERSION         = 2;
+static constexpr size_t     BUFFER_BYTES    = 1 << 20;
+static constexpr long       BOOKS_OFFSET    = sizeof(MAGIC) + sizeof(VERSION);
+
+SnapshotWriter::SnapshotWriter(char const * filename, SnapshotInfo const & info) :
+    out(std::fopen(filename, "wb")),
+    buffer(BUFFER_BYTES),
+    used(0),
+    books(0) {
+    if (!out) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    for (char const c : MAGIC) put(c);
+    put(VERSION);
+    put(uint32_t(0));               // book count, filled in by finish()
+    put(info.offset);
+    put(info.messages);
+    put(info.timestamp);
+    put(info.fileBytes);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (!out) return;
+    // errors can no longer be reported
+    try { finish(); } catch (std::exception const &) {}
+}
+
+void SnapshotWriter::flush() {
+    if (std::fwrite(buffer.data(), 1, used, out) != used) throw std::runtime_error("Failed to write snapshot");
+    used = 0;
+}
+
+void SnapshotWriter::finish() {
+    if (!out) return;
+    flush();
+    bool const ok = !std::fseek(out, BOOKS_OFFSET, SEEK_SET) && std::fwrite(&books, sizeof(books), 1, out) == 1;
+    bool const closed = !std::fclose(out);
+    out = nullptr;
+    if (!ok || !closed) throw std::runtime_error("Failed to write snapshot");
+}
+
+SnapshotReader::SnapshotReader(char const * filename) : data(nullptr), size(0), books(0) {
+    int const fd = open(filename, O_RDONLY);
+    if (fd == -1) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    struct stat st;
+    if (fstat(fd, &st) == -1 || size_t(st.st_size) < HEADER_BYTES) { close(fd); throw std::invalid_argument(std::string("Not a snapshot: ") + filename); }
+    size = st.st_size;
+    void * const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) throw std::runtime_error(std::string("Failed to map file: ") + filename);
+    data = static_cast<char const *>(mapping);
+
+    char const * p = data;
+    bool valid = !std::memcmp(p, MAGIC, sizeof(MAGIC));
+    p += sizeof(MAGIC);
+    valid = valid && get<uint32_t>(p) == VERSION;
+    books = get<uint32_t>(p);
+    header.offset = get<uint64_t>(p);
+    header.messages = get<uint64_t>(p);
+    header.timestamp = get<uint64_t>(p);
+    header.fileBytes = get<uint64_t>(p);
+
+    // walk the level headers, so a truncated file is caught before anything is restored
+    char const * const end = data + size;
+    for (uint32_t b = 0; valid && b < books; ++b) {
+        if (end - p < 10) { valid = false; break; }
+        p += sizeof(uint16_t);
+        uint64_t const levels = uint64_t(get<uint32_t>(p)) + get<uint32_t>(p);
+        for (uint64_t l = 0; valid && l < levels; ++l) {
+            if (end - p < 8) { valid = false; break; }
+            p += sizeof(uint32_t);
+            uint64_t const orderBytes = uint64_t(get<uint32_t>(p)) * ORDER_BYTES;
+            if (uint64_t(end - p) < orderBytes) { valid = false; break; }
+            p += orderBytes;
+        }
+    }
+    if (!valid || p != end) {
+        munmap(mapping, size);
+        throw std::invalid_argument(std::string("Not a complete snapshot: ") + filename);
+    }
+}
+
+SnapshotReader::~SnapshotReader() {
+    munmap(const_cast<char *>(data), size);
+}
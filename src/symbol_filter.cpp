@@ -0,0 +1,87 @@
+#include "symbol_filter.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t STOCK_LENGTH = 8;
+
+uint64_t stockKey(char const * stock) {
+    uint64_t key;
+    std::memcpy(&key, stock, sizeof(key));
+    return key;
+}
+
+// trims surrounding whitespace, the directory pads with spaces on the right
+std::string trim(std::string const & s) {
+    size_t const first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return std::string();
+    size_t const last = s.find_last_not_of(" \t\r\n");
+    return s.substr(first, last - first + 1);
+}
+
+} // namespace
+
+SymbolFilter::SymbolFilter(std::vector<std::string> const & _tickers) : resolvedCount(0), seen(0), kept(0) {
+    for (std::string const & ticker : _tickers) {
+        if (ticker.empty() || ticker.size() > STOCK_LENGTH) throw std::invalid_argument(std::string("Not an ITCH ticker: ") + ticker);
+        char stock[STOCK_LENGTH];
+        std::memset(stock, ' ', sizeof(stock));
+        std::memcpy(stock, ticker.data(), ticker.size());
+        if (byStock.emplace(stockKey(stock), tickers.size()).second) tickers.push_back(ticker);
+    }
+    found.resize(tickers.size());
+}
+
+std::vector<std::string> SymbolFilter::parse(char const * list) {
+    std::vector<std::string> tickers;
+    char const * p = list;
+    while (true) {
+        char const * const comma = std::strchr(p, ',');
+        std::string const ticker = trim(comma ? std::string(p, comma) : std::string(p));
+        if (!ticker.empty()) tickers.push_back(ticker);
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return tickers;
+}
+
+std::vector<std::string> SymbolFilter::load(char const * filename) {
+    std::ifstream in(filename);
+    if (!in) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    std::vector<std::string> tickers;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string const ticker = trim(line);
+        if (!ticker.empty()) tickers.push_back(ticker);
+    }
+    return tickers;
+}
+
+bool SymbolFilter::subscribe(ITCH::StockDirectoryView const & view) {
+    auto const it = byStock.find(stockKey(view.stock()));
+    if (it == byStock.end()) return false;
+    locates[view.stockLocate()] = true;
+    if (!found[it->second]) {
+        found[it->second] = true;
+        ++resolvedCount;
+    }
+    return true;
+}
+
+std::vector<std::string> SymbolFilter::unresolved() const {
+    std::vector<std::string> missing;
+    for (size_t i = 0; i < tickers.size(); ++i) {
+        if (!found[i]) missing.push_back(tickers[i]);
+    }
+    return missing;
+}
+
+void SymbolFilter::reset() {
+    locates.reset();
+    found.assign(tickers.size(), false);
+    resolvedCount = 0;
+    seen = 0;
+    kept = 0;
+}
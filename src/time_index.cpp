@@ -0,0 +1,77 @@
+#include "time_index.hpp"
+#include "itch_reader.hpp"
+#include <algorithm>                // upper_bound
+#include <cstdio>
+#include <cstring>                  // memcmp
+#include <stdexcept>
+#include <sys/stat.h>               // stat
+
+static constexpr char       MAGIC[8]    = {'O', 'B', 'T', 'I', 'D', 'X', 0, 0};
+static constexpr uint32_t   VERSION     = 1;
+
+TimeIndex TimeIndex::build(char const * itchFilename, Interval const & interval) {
+    ITCH::MappedReader reader(itchFilename);
+    // the whole file, an end of session marker or trailing bytes after the last message included, as the loader's stat() sees it
+    struct stat st;
+    if (stat(itchFilename, &st) == -1) throw std::invalid_argument(std::string("Failed to stat file: ") + itchFilename);
+    std::vector<TimeCheckpoint> entries;
+    uint64_t messages = 0;
+    uint64_t nextMessages = 0;
+    uint64_t nextTimestamp = 0;
+    uint64_t offset = 0;
+    char const * messageData;
+    while ((messageData = reader.nextMessage())) {
+        uint64_t const timestamp = ITCH::Parser::getDataTimestamp(messageData);
+        if (messages >= nextMessages || timestamp >= nextTimestamp) {
+            // timestamps never go back, so every message before this one is earlier than the checkpoint or equal to it
+            entries.push_back(TimeCheckpoint{entries.empty() ? 0 : timestamp, offset, messages});
+            nextMessages = messages + interval.messages;
+            nextTimestamp = interval.nanoseconds ? (timestamp / interval.nanoseconds + 1) * interval.nanoseconds : UINT64_MAX;
+        }
+        ++messages;
+        offset = reader.getOffset();
+    }
+    if (entries.empty()) entries.push_back(TimeCheckpoint{0, 0, 0});
+    return TimeIndex(std::move(entries), st.st_size);
+}
+
+TimeIndex::TimeIndex(char const * indexFilename, uint64_t _itchBytes) : itchBytes(_itchBytes) {
+    FILE * const in = std::fopen(indexFilename, "rb");
+    if (!in) throw std::invalid_argument(std::string("Failed to open file: ") + indexFilename);
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    uint64_t indexed = 0;
+    bool valid = std::fread(magic, sizeof(magic), 1, in) == 1 && !std::memcmp(magic, MAGIC, sizeof(MAGIC))
+        && std::fread(&version, sizeof(version), 1, in) == 1 && version == VERSION
+        && std::fread(&count, sizeof(count), 1, in) == 1 && count
+        && std::fread(&indexed, sizeof(indexed), 1, in) == 1;
+    if (valid) {
+        entries.resize(count);
+        valid = std::fread(entries.data(), sizeof(TimeCheckpoint), count, in) == count;
+    }
+    std::fclose(in);
+    if (!valid) throw std::invalid_argument(std::string("Not a complete time index: ") + indexFilename);
+    // an index of a file that has since been rewritten or appended to points at the wrong bytes
+    if (indexed != itchBytes) throw std::invalid_argument(std::string("Time index is out of date: ") + indexFilename);
+}
+
+void TimeIndex::write(char const * indexFilename) const {
+    FILE * const out = std::fopen(indexFilename, "wb");
+    if (!out) throw std::invalid_argument(std::string("Failed to open file: ") + indexFilename);
+    uint32_t const count = entries.size();
+    bool const ok = std::fwrite(MAGIC, sizeof(MAGIC), 1, out) == 1
+        && std::fwrite(&VERSION, sizeof(VERSION), 1, out) == 1
+        && std::fwrite(&count, sizeof(count), 1, out) == 1
+        && std::fwrite(&itchBytes, sizeof(itchBytes), 1, out) == 1
+        && std::fwrite(entries.data(), sizeof(TimeCheckpoint), count, out) == count;
+    bool const closed = !std::fclose(out);
+    if (!ok || !closed) throw std::runtime_error(std::string("Failed to write time index: ") + indexFilename);
+}
+
+TimeCheckpoint const & TimeIndex::seek(uint64_t timestamp) const {
+    // first checkpoint at or after timestamp, the one before it can only precede messages earlier than timestamp
+    auto const after = std::lower_bound(entries.begin() + 1, entries.end(), timestamp,
+            [](TimeCheckpoint const & c, uint64_t t) { return c.timestamp < t; });
+    return *(after - 1);
+}
@@ -0,0 +1,151 @@
+#include "trade_tape.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+TradeTape::TradeTape(char const * filename, uint64_t _interval) :
+    out(std::fopen(filename, "wb")),
+    interval(_interval),
+    windowEnd(0),
+    totals(1 << 16),
+    lastPrint(1 << 16, NONE),
+    bars(1 << 16),
+    written(0),
+    broken(0),
+    unmatched(0) {
+    if (!out) throw std::invalid_argument(std::string("Failed to open file: ") + filename);
+    if (!interval) {
+        std::fclose(out);
+        throw std::invalid_argument("Bar interval must be positive");
+    }
+    // match numbers start at 1
+    byMatch.set_empty_key(0);
+    buffer.reserve(BUFFER_RECORDS);
+}
+
+// whatever is still buffered, errors can no longer be reported
+TradeTape::~TradeTape() {
+    std::fwrite(buffer.data(), sizeof(BarRecord), buffer.size(), out);
+    std::fclose(out);
+}
+
+void TradeTape::flush() {
+    if (buffer.empty()) return;
+    if (std::fwrite(buffer.data(), sizeof(BarRecord), buffer.size(), out) != buffer.size()) {
+        throw std::runtime_error("Failed to write bars");
+    }
+    written += buffer.size();
+    buffer.clear();
+}
+
+void TradeTape::finish() {
+    closeBars();
+    flush();
+    std::fflush(out);
+}
+
+void TradeTape::closeBars() {
+    for (uint16_t const stockLocate : open) {
+        opened[stockLocate] = false;
+        // every trade of it may have been broken
+        if (bars[stockLocate].trades) write(bars[stockLocate]);
+    }
+    open.clear();
+}
+
+void TradeTape::advance(uint64_t timestamp) {
+    closeBars();
+    windowEnd = timestamp - timestamp % interval + interval;
+}
+
+void TradeTape::print(uint64_t timestamp, uint16_t stockLocate, uint32_t price, uint32_t shares, uint64_t matchNumber) {
+    if (timestamp >= windowEnd) advance(timestamp);
+    uint32_t const index = static_cast<uint32_t>(prints.size());
+    prints.push_back(Print{timestamp, stockLocate, price, shares, lastPrint[stockLocate]});
+    byMatch[matchNumber] = index;
+
+    uint64_t const notional = uint64_t(price) * shares;
+    TradeStats & stats = totals[stockLocate];
+    stats.volume += shares;
+    stats.notional += notional;
+    stats.lastTimestamp = timestamp;
+    ++stats.trades;
+    stats.lastPrice = price;
+    stats.lastShares = shares;
+    lastPrint[stockLocate] = index;
+
+    BarRecord & bar = bars[stockLocate];
+    if (!opened[stockLocate]) {
+        opened[stockLocate] = true;
+        open.push_back(stockLocate);
+        bar = BarRecord{windowEnd - interval, stockLocate, 0, 0, 0, 0, 0, 0, 0, 0};
+    }
+    // also once every earlier trade of the bar was broken
+    if (!bar.trades) bar.open = bar.high = bar.low = price;
+    bar.high = std::max(bar.high, price);
+    bar.low = std::min(bar.low, price);
+    bar.close = price;
+    bar.volume += shares;
+    bar.notional += notional;
+    ++bar.trades;
+}
+
+/*
+ * Broken trades
+ * NASDAQ breaks a trade by its match number, possibly long after its bar was written
+ * the totals are net of it straight away, the last trade falls back to the one before it,
+ * and its bar is rebuilt from the prints still standing, replacing the open bar or written as a new revision
+ */
+void TradeTape::breakTrade(uint64_t timestamp, uint16_t stockLocate, uint64_t matchNumber) {
+    if (timestamp >= windowEnd) advance(timestamp);
+    auto const found = byMatch.find(matchNumber);
+    if (found == byMatch.end() || !prints[found->second].shares || prints[found->second].stockLocate != stockLocate) {
+        ++unmatched;
+        return;
+    }
+    uint32_t const index = found->second;
+    Print & p = prints[index];
+    ++broken;
+
+    TradeStats & stats = totals[stockLocate];
+    stats.volume -= p.shares;
+    stats.notional -= uint64_t(p.price) * p.shares;
+    --stats.trades;
+    p.shares = 0;
+    if (lastPrint[stockLocate] == index) {
+        // back along the locate's own prints, past any broken since they were linked
+        uint32_t last = p.previous;
+        while (last != NONE && !prints[last].shares) last = prints[last].previous;
+        lastPrint[stockLocate] = last;
+        Print const * const previous = last != NONE ? &prints[last] : nullptr;
+        stats.lastTimestamp = previous ? previous->timestamp : 0;
+        stats.lastPrice = previous ? previous->price : 0;
+        stats.lastShares = previous ? previous->shares : 0;
+    }
+
+    uint64_t const start = p.timestamp - p.timestamp % interval;
+    if (opened[stockLocate] && bars[stockLocate].start == start) bars[stockLocate] = rebuild(stockLocate, start);
+    else write(rebuild(stockLocate, start));
+}
+
+BarRecord TradeTape::rebuild(uint16_t stockLocate, uint64_t start) const {
+    BarRecord bar{start, stockLocate, 0, 0, 0, 0, 0, 0, 0, 0};
+    auto p = std::lower_bound(prints.begin(), prints.end(), start, [](Print const & print, uint64_t timestamp) {
+        return print.timestamp < timestamp;
+    });
+    for (; p != prints.end() && p->timestamp < start + interval; ++p) {
+        if (p->stockLocate != stockLocate) continue;
+        if (!p->shares) {
+            ++bar.revision;
+            continue;
+        }
+        if (!bar.trades) bar.open = bar.high = bar.low = p->price;
+        bar.high = std::max(bar.high, p->price);
+        bar.low = std::min(bar.low, p->price);
+        bar.close = p->price;
+        bar.volume += p->shares;
+        bar.notional += uint64_t(p->price) * p->shares;
+        ++bar.trades;
+    }
+    return bar;
+}
@@ -0,0 +1,259 @@
+// Replays many ITCH files, e.g. a few hundred days, concurrently
+// each pool thread owns one BookSet and takes the next file as it finishes one,
+// its books are cleared between files so the Order/Level pools stay committed and are reused
+// usage: ./book-batch [options] itch_filename_or_glob...
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "compressed_reader.hpp"
+#include "prefetch_reader.hpp"
+#include "book_set.hpp"
+#include "message_batch.hpp"
+#include "symbol_filter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glob.h>                   // glob
+#include <sys/stat.h>               // stat
+
+namespace {
+
+struct Options {
+    size_t              threads     = std::max(1u, std::thread::hardware_concurrency());
+    char const *        reader      = "mmap";
+    size_t              batchSize   = 0;
+    BookPools::Config   pools;
+    std::vector<std::string> symbols;   // every locate if empty
+};
+
+struct File {
+    std::string name;
+    uint64_t    bytes       = 0;
+    // filled in once replayed
+    uint64_t    messages    = 0;
+    uint64_t    kept        = 0;    // passed the symbol filter
+    double      seconds     = 0;
+    bool        ok          = false;
+};
+
+// arguments with wildcards are expanded here, so a quoted glob works past the shell's argument limit
+bool addFiles(char const * pattern, std::vector<File> & files) {
+    glob_t matches;
+    int const status = glob(pattern, GLOB_NOCHECK, nullptr, &matches);
+    if (status) {
+        globfree(&matches);
+        return false;
+    }
+    for (size_t i = 0; i < matches.gl_pathc; ++i) files.push_back(File{matches.gl_pathv[i]});
+    globfree(&matches);
+    return true;
+}
+
+bool addList(char const * listFilename, std::vector<File> & files) {
+    std::ifstream list(listFilename);
+    if (!list) return false;
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty()) files.push_back(File{line});
+    }
+    return true;
+}
+
+// with symbols only the messages it passes reach the books
+template <typename Reader>
+uint64_t replay(Reader & reader, BookSet & books, ITCH::MessageBatch & batch, size_t batchSize, SymbolFilter * symbols) {
+    uint64_t messages = 0;
+    char const * messageData;
+    if (symbols) {
+        while ((messageData = reader.nextMessage())) {
+            ++messages;
+            if (!symbols->pass(messageData)) continue;
+            if (!batchSize) books.handleMessage(messageData);
+            else if (batch.push(messageData)) {
+                books.handleBatch(batch.data(), batch.size());
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) books.handleBatch(batch.data(), batch.size());
+        batch.clear();
+    } else if (batchSize) {
+        while ((messageData = reader.nextMessage())) {
+            if (batch.push(messageData)) {
+                books.handleBatch(batch.data(), batch.size());
+                batch.clear();
+            }
+            ++messages;
+        }
+        if (!batch.empty()) books.handleBatch(batch.data(), batch.size());
+        batch.clear();
+    } else {
+        while ((messageData = reader.nextMessage())) {
+            books.handleMessage(messageData);
+            ++messages;
+        }
+    }
+    return messages;
+}
+
+class Pool {
+public:
+    Pool(Options const & _options, std::vector<File> & _files) : options(_options), files(_files), next(0) {}
+
+    void run() {
+        std::vector<std::thread> threads;
+        size_t const count = std::min(options.threads, files.size());
+        for (size_t i = 0; i < count; ++i) threads.emplace_back(&Pool::work, this);
+        for (std::thread & thread : threads) thread.join();
+    }
+
+private:
+    void work() {
+        // with FLAT_ORDER_INDEX the order index is per thread, so the books are built and torn down here
+        BookSet books(options.pools);
+        ITCH::MessageBatch batch(options.batchSize);
+        // locates are assigned per day, each file learns its own
+        std::unique_ptr<SymbolFilter> symbols;
+        if (!options.symbols.empty()) symbols = std::make_unique<SymbolFilter>(options.symbols);
+        size_t i;
+        while ((i = next.fetch_add(1, std::memory_order_relaxed)) < files.size()) {
+            File & file = files[i];
+            auto const t1 = std::chrono::steady_clock::now();
+            try {
+                if (ITCH::CompressedReader::detect(file.name.c_str()) != ITCH::CompressedReader::Format::RAW) {
+                    // files are already replayed in parallel, one decompressing thread each is enough
+                    ITCH::CompressedReader reader(file.name.c_str());
+                    file.messages = replay(reader, books, batch, options.batchSize, symbols.get());
+                } else if (!std::strcmp(options.reader, "prefetch")) {
+                    ITCH::PrefetchReader reader(file.name.c_str());
+                    file.messages = replay(reader, books, batch, options.batchSize, symbols.get());
+                } else if (!std::strcmp(options.reader, "buffered")) {
+                    ITCH::Reader reader(file.name.c_str(), 16384);
+                    file.messages = replay(reader, books, batch, options.batchSize, symbols.get());
+                } else {
+                    ITCH::MappedReader reader(file.name.c_str());
+                    file.messages = replay(reader, books, batch, options.batchSize, symbols.get());
+                }
+                file.ok = true;
+            } catch (std::exception const & e) {
+                std::lock_guard<std::mutex> lock(output);
+                std::cerr << file.name << ": " << e.what() << std::endl;
+            }
+            // end of day, the orders still resting go back to the pools for the next file
+            // and a file that failed part way leaves messages of its reader in the batch
+            books.clear();
+            batch.clear();
+            if (symbols) {
+                file.kept = symbols->messagesKept();
+                symbols->reset();
+            }
+            file.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+            if (file.ok) {
+                std::lock_guard<std::mutex> lock(output);
+                std::cout << file.name << ": " << file.messages << " messages (" << file.bytes << " bytes) in "
+                    << file.seconds * 1000 << " milliseconds (" << file.messages / file.seconds / 1000000 << "M messages/s, "
+                    << file.bytes / file.seconds / 1000000 << " MB/s)";
+                if (symbols) std::cout << ", kept " << file.kept;
+                std::cout << std::endl;
+            }
+        }
+    }
+
+    Options const &     options;
+    std::vector<File> & files;
+    std::atomic<size_t> next;
+    std::mutex          output;
+};
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    Options options;
+    std::vector<File> files;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = std::strtoul(argv[++i], nullptr, 10);
+            ok = options.threads > 0;
+        } else if (!std::strcmp(argv[i], "--reader") && i + 1 < argc) {
+            options.reader = argv[++i];
+            // a misspelt backend would otherwise be measured as another one
+            ok = !std::strcmp(options.reader, "mmap") || !std::strcmp(options.reader, "buffered") || !std::strcmp(options.reader, "prefetch");
+        } else if (!std::strcmp(argv[i], "--batch") && i + 1 < argc) {
+            options.batchSize = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--list") && i + 1 < argc) {
+            ok = addList(argv[++i], files);
+            if (!ok) std::perror(argv[i]);
+        } else if (!std::strcmp(argv[i], "--symbols") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::parse(argv[++i]);
+            options.symbols.insert(options.symbols.end(), listed.begin(), listed.end());
+        } else if (!std::strcmp(argv[i], "--symbols-file") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::load(argv[++i]);
+            options.symbols.insert(options.symbols.end(), listed.begin(), listed.end());
+        } else if (!std::strcmp(argv[i], "--order-capacity") && i + 1 < argc) {
+            options.pools.orderCapacity = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--reserve-orders") && i + 1 < argc) {
+            options.pools.reserveOrders = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--huge-pages")) {
+            options.pools.hugePages = true;
+        } else if (argv[i][0] == '-') {
+            // an unknown option or one missing its value
+            ok = false;
+        } else {
+            ok = addFiles(argv[i], files);
+        }
+    }
+
+    if (!ok || files.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--threads N] [--reader mmap|buffered|prefetch] [--batch K] [--list list_filename] [--symbols TICKER,...] [--symbols-file filename] [--order-capacity N] [--reserve-orders N] [--huge-pages] [itch_filename_or_glob...]" << std::endl;
+        std::cout << "\n" << "where" << '\n'
+            << "\t" << "itch_filename_or_glob: NasdaqTotalViewITCH files in BinaryFILE format, optionally gzip or zstd compressed, quote a glob to expand it here" << '\n'
+            << "\t" << "--threads: files replayed at once, each on its own thread with its own books (default one per core)" << '\n'
+            << "\t" << "--reader: read each file through a memory mapping (default), through a reused buffer, or ahead on an I/O thread" << '\n'
+            << "\t" << "--batch: apply messages K at a time, prefetching their orders with FLAT_ORDER_INDEX (default 0, one at a time)" << '\n'
+            << "\t" << "--list: also replay the files named in list_filename, one per line" << '\n'
+            << "\t" << "--symbols: only build books for these tickers, every other locate is dropped as it is read" << '\n'
+            << "\t" << "--symbols-file: as --symbols, one ticker per line" << '\n'
+            << "\t" << "--order-capacity: most orders resting at once, per thread (default 2^28)" << '\n'
+            << "\t" << "--reserve-orders: commit memory for this many orders per thread at startup, kept across files" << '\n'
+            << "\t" << "--huge-pages: back the order and level pools with huge pages"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for (File & file : files) {
+        struct stat st;
+        if (stat(file.name.c_str(), &st) == 0) file.bytes = st.st_size;
+    }
+    // largest first, so the last file to start is a short one and the threads finish together
+    std::stable_sort(files.begin(), files.end(), [](File const & a, File const & b) { return a.bytes > b.bytes; });
+
+    auto const t1 = std::chrono::steady_clock::now();
+    Pool pool(options, files);
+    pool.run();
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+    uint64_t messages = 0, bytes = 0;
+    size_t replayed = 0;
+    for (File const & file : files) {
+        if (!file.ok) continue;
+        messages += file.messages;
+        bytes += file.bytes;
+        ++replayed;
+    }
+    std::cout << "replayed " << replayed << " of " << files.size() << " files, " << messages << " messages (" << bytes << " bytes) in "
+        << seconds * 1000 << " milliseconds on " << std::min(options.threads, files.size()) << " threads" << std::endl;
+    if (seconds > 0) {
+        std::cout << "(" << messages / seconds / 1000000 << "M messages/s, " << bytes / seconds / 1000000 << " MB/s, "
+            << replayed / seconds * 3600 << " files/hour)" << std::endl;
+    }
+    return replayed == files.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
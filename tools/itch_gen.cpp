@@ -0,0 +1,469 @@
+// Deterministic synthetic NASDAQ ITCH 5.0 stream in BinaryFILE format
+// one directory entry per symbol, then an order flow of adds, deletes, replaces, executions and cancels
+// against the orders each symbol has resting, bracketed by the system events of a trading day
+// optionally with opening and closing crosses, non-displayed trades and broken trades
+// the same options and seed always produce the same bytes, on any platform
+// usage: ./itch-gen [options] output_filename
+#include "itch_common.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// splitmix64, std distributions differ between standard libraries
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+    // [0, n)
+    uint64_t below(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * n) >> 64); }
+    // [lo, hi]
+    uint64_t between(uint64_t lo, uint64_t hi) { return lo + below(hi - lo + 1); }
+    // [0, 1)
+    double real() { return (next() >> 11) * 0x1.0p-53; }
+    bool chance(double p) { return real() < p; }
+private:
+    uint64_t state;
+};
+
+// big endian message encoder into a growing buffer, flushed to the file as it fills
+class Writer {
+public:
+    explicit Writer(FILE * _out) : out(_out), bytes(0) { buffer.reserve(FLUSH_BYTES + 64); }
+    ~Writer() { flush(); }
+
+    // length prefix and the header every message starts with
+    template <ITCH::MessageType_t MessageType>
+    void begin(uint16_t stockLocate, uint64_t timestamp) {
+        start = buffer.size();
+        put16(ITCH::MessageLength<MessageType>);
+        put8(MessageType);
+        put16(stockLocate);
+        put16(0);               // tracking number
+        put16(timestamp >> 32);
+        put32(timestamp);
+    }
+    // checks the body against the spec length
+    template <ITCH::MessageType_t MessageType>
+    void end() {
+        if (buffer.size() - start != ITCH::messageHeaderLength + ITCH::MessageLength<MessageType>) {
+            std::cerr << "bad length for message type " << MessageType << std::endl;
+            std::abort();
+        }
+        if (buffer.size() >= FLUSH_BYTES) flush();
+    }
+
+    void put8(uint8_t v)    { buffer.push_back(static_cast<char>(v)); }
+    void put16(uint16_t v)  { put8(v >> 8); put8(v); }
+    void put32(uint32_t v)  { put16(v >> 16); put16(v); }
+    void put64(uint64_t v)  { put32(v >> 32); put32(v); }
+    void putBytes(char const * s, size_t n) { buffer.insert(buffer.end(), s, s + n); }
+
+    void flush() {
+        if (buffer.empty()) return;
+        if (std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+            std::perror("itch-gen: write");
+            std::exit(EXIT_FAILURE);
+        }
+        bytes += buffer.size();
+        buffer.clear();
+    }
+    uint64_t bytesWritten() const { return bytes + buffer.size(); }
+
+private:
+    static constexpr size_t FLUSH_BYTES = 1 << 20;
+    FILE *              out;
+    std::vector<char>   buffer;
+    size_t              start;
+    uint64_t            bytes;
+};
+
+// relative weights of the order flow, defaults are the counts of 12302019.NASDAQ_ITCH50 (see README)
+struct Mix {
+    double add      = 118631456;
+    double del      = 114360997;
+    double replace  = 21639067;
+    double execute  = 5822741;
+    double cancel   = 2787676;
+};
+
+struct Config {
+    uint32_t    symbols             = 100;
+    uint64_t    ordersPerSymbol     = 10000;
+    Mix         mix;
+    double      skew                = 0.3;      // p of the geometric distance from the touch in ticks
+    uint64_t    seed                = 1;
+    double      attributedAdds      = 0.05;     // share of adds sent as F
+    double      executionsWithPrice = 0.05;     // share of executions sent as C
+    double      trades              = 0;        // non-displayed trades (P) per execution, and crosses (Q) if above 0
+    double      broken              = 0;        // share of prints broken (B) later in the day
+};
+
+struct LiveOrder {
+    uint64_t    referenceNumber;
+    uint32_t    shares;
+    uint32_t    price;
+    char        side;
+};
+
+struct Symbol {
+    uint32_t                mid;                // ITCH price units, 4 implied decimals
+    std::vector<LiveOrder>  live;
+    std::vector<uint64_t>   toBreak;            // match numbers of prints still to be broken
+};
+
+constexpr uint32_t  TICK        = 100;          // $0.01
+constexpr uint32_t  MAX_TICKS   = 500;          // furthest an order rests from the mid
+constexpr uint64_t  HOUR        = 3600 * 1000000000ULL;   // timestamps are ns since midnight
+constexpr uint64_t  MINUTE      = HOUR / 60;
+
+std::string stockName(uint32_t locate) {
+    std::string name = "S";
+    for (uint32_t l = locate; l; l /= 26) name += static_cast<char>('A' + l % 26);
+    name.resize(8, ' ');
+    return name;
+}
+
+class Generator {
+public:
+    Generator(Config const & _config, Writer & _writer) :
+        config(_config), writer(_writer), rng(_config.seed), symbols(_config.symbols),
+        nextReference(1), nextMatch(1), timestamp(0), messages(0) {
+        Mix const & m = config.mix;
+        double const total = m.add + m.del + m.replace + m.execute + m.cancel;
+        cumulative[0] = m.add / total;
+        cumulative[1] = cumulative[0] + m.del / total;
+        cumulative[2] = cumulative[1] + m.replace / total;
+        cumulative[3] = cumulative[2] + m.execute / total;
+        // spread the order flow evenly over market hours
+        uint64_t const adds = uint64_t(config.symbols) * config.ordersPerSymbol;
+        uint64_t const expected = std::max<uint64_t>(1, static_cast<uint64_t>(adds / std::max(cumulative[0], 1e-9)));
+        step = std::max<uint64_t>(1, (6 * HOUR + 30 * MINUTE) / expected);
+    }
+
+    void run() {
+        systemEvent(3 * HOUR, 'O');
+        for (uint32_t locate = 1; locate <= config.symbols; ++locate) {
+            stockDirectory(3 * HOUR + locate, locate);
+            symbols[locate - 1].mid = static_cast<uint32_t>(rng.between(10, 500)) * 10000;
+        }
+        systemEvent(4 * HOUR, 'S');
+        systemEvent(9 * HOUR + 30 * MINUTE, 'Q');
+        timestamp = 9 * HOUR + 30 * MINUTE;
+        if (config.trades > 0) crosses('O');
+
+        uint64_t const adds = uint64_t(config.symbols) * config.ordersPerSymbol;
+        uint64_t added = 0;
+        while (added < adds) {
+            timestamp += step;
+            uint32_t const locate = static_cast<uint32_t>(rng.below(config.symbols)) + 1;
+            Symbol & s = symbols[locate - 1];
+            // a while after the print, usually in a later bar
+            if (!s.toBreak.empty() && rng.chance(0.01)) {
+                brokenTrade(locate, s.toBreak.front());
+                s.toBreak.erase(s.toBreak.begin());
+                continue;
+            }
+            double const r = rng.real();
+            if (r < cumulative[0] || s.live.empty()) {
+                add(locate, s);
+                ++added;
+            } else {
+                size_t const i = rng.below(s.live.size());
+                if (r < cumulative[1]) remove(locate, s, i);
+                else if (r < cumulative[2]) replace(locate, s, i);
+                else if (r < cumulative[3]) execute(locate, s, i);
+                else cancel(locate, s, i);
+            }
+        }
+
+        timestamp = std::max(timestamp, 16 * HOUR);
+        if (config.trades > 0) crosses('C');
+        for (uint32_t locate = 1; locate <= config.symbols; ++locate) {
+            for (uint64_t const match : symbols[locate - 1].toBreak) brokenTrade(locate, match);
+        }
+        systemEvent(timestamp, 'M');
+        systemEvent(std::max(timestamp, 20 * HOUR), 'E');
+        systemEvent(std::max(timestamp, 20 * HOUR) + 5 * MINUTE, 'C');
+    }
+
+    uint64_t messageCount() const { return messages; }
+
+private:
+    // ticks from the touch, geometric so most orders rest near it
+    uint32_t depth() {
+        double const u = 1 - rng.real();
+        uint32_t const ticks = config.skew >= 1 ? 0 : static_cast<uint32_t>(std::log(u) / std::log(1 - config.skew));
+        return std::min(ticks, MAX_TICKS);
+    }
+    uint32_t priceFor(Symbol const & s, char side) {
+        uint32_t const offset = (1 + depth()) * TICK;
+        return side == ITCH::Side::BUY ? std::max(TICK, s.mid - std::min(offset, s.mid - TICK)) : s.mid + offset;
+    }
+    uint32_t shares() {
+        return rng.chance(0.9) ? static_cast<uint32_t>(rng.between(1, 10)) * 100 : static_cast<uint32_t>(rng.between(1, 99));
+    }
+
+    void add(uint32_t locate, Symbol & s) {
+        char const side = rng.chance(0.5) ? ITCH::Side::BUY : ITCH::Side::SELL;
+        LiveOrder const o{nextReference++, shares(), priceFor(s, side), side};
+        std::string const stock = stockName(locate);
+        if (rng.chance(config.attributedAdds)) {
+            writer.begin<ITCH::AddOrderMPIDAttributionMessageType>(locate, timestamp);
+            writeAdd(o, stock);
+            writer.putBytes("GENR", 4);
+            writer.end<ITCH::AddOrderMPIDAttributionMessageType>();
+        } else {
+            writer.begin<ITCH::AddOrderMessageType>(locate, timestamp);
+            writeAdd(o, stock);
+            writer.end<ITCH::AddOrderMessageType>();
+        }
+        s.live.push_back(o);
+        ++messages;
+    }
+    void writeAdd(LiveOrder const & o, std::string const & stock) {
+        writer.put64(o.referenceNumber);
+        writer.put8(o.side);
+        writer.put32(o.shares);
+        writer.putBytes(stock.data(), 8);
+        writer.put32(o.price);
+    }
+
+    void remove(uint32_t locate, Symbol & s, size_t i) {
+        writer.begin<ITCH::OrderDeleteMessageType>(locate, timestamp);
+        writer.put64(s.live[i].referenceNumber);
+        writer.end<ITCH::OrderDeleteMessageType>();
+        s.live[i] = s.live.back();
+        s.live.pop_back();
+        ++messages;
+    }
+
+    // same side, within a few ticks of the old price
+    void replace(uint32_t locate, Symbol & s, size_t i) {
+        LiveOrder & o = s.live[i];
+        int64_t const moved = int64_t(o.price) + (int64_t(rng.between(0, 6)) - 3) * TICK;
+        uint32_t const price = static_cast<uint32_t>(std::max<int64_t>(TICK, moved));
+        uint32_t const newShares = shares();
+        writer.begin<ITCH::OrderReplaceMessageType>(locate, timestamp);
+        writer.put64(o.referenceNumber);
+        writer.put64(nextReference);
+        writer.put32(newShares);
+        writer.put32(price);
+        writer.end<ITCH::OrderReplaceMessageType>();
+        o = LiveOrder{nextReference++, newShares, price, o.side};
+        ++messages;
+    }
+
+    // fills half the time, the mid follows the fill
+    void execute(uint32_t locate, Symbol & s, size_t i) {
+        LiveOrder & o = s.live[i];
+        uint32_t const executed = rng.chance(0.5) || o.shares == 1 ? o.shares : static_cast<uint32_t>(rng.between(1, o.shares - 1));
+        if (rng.chance(config.executionsWithPrice)) {
+            writer.begin<ITCH::OrderExecutedWithPriceMessageType>(locate, timestamp);
+            writer.put64(o.referenceNumber);
+            writer.put32(executed);
+            writer.put64(nextMatch++);
+            writer.put8('Y');
+            writer.put32(o.price);
+            writer.end<ITCH::OrderExecutedWithPriceMessageType>();
+        } else {
+            writer.begin<ITCH::OrderExecutedMessageType>(locate, timestamp);
+            writer.put64(o.referenceNumber);
+            writer.put32(executed);
+            writer.put64(nextMatch++);
+            writer.end<ITCH::OrderExecutedMessageType>();
+        }
+        ++messages;
+        printed(s, nextMatch - 1);
+        if (config.trades > 0 && rng.chance(config.trades)) trade(locate, s, o.price);
+        s.mid = o.side == ITCH::Side::BUY ? std::max(2 * TICK, o.price + TICK) : std::max(2 * TICK, o.price - TICK);
+        o.shares -= executed;
+        if (!o.shares) {
+            s.live[i] = s.live.back();
+            s.live.pop_back();
+        }
+    }
+
+    // partial only, a cancel of every share is sent as a delete as NASDAQ does
+    void cancel(uint32_t locate, Symbol & s, size_t i) {
+        LiveOrder & o = s.live[i];
+        if (o.shares == 1) {
+            remove(locate, s, i);
+            return;
+        }
+        uint32_t const cancelled = static_cast<uint32_t>(rng.between(1, o.shares - 1));
+        writer.begin<ITCH::OrderCancelMessageType>(locate, timestamp);
+        writer.put64(o.referenceNumber);
+        writer.put32(cancelled);
+        writer.end<ITCH::OrderCancelMessageType>();
+        o.shares -= cancelled;
+        ++messages;
+    }
+
+    // a hidden order trading at the price of the last execution
+    void trade(uint32_t locate, Symbol & s, uint32_t price) {
+        writer.begin<ITCH::TradeMessageType>(locate, timestamp);
+        writer.put64(0);            // order reference numbers of trades are always 0
+        writer.put8(rng.chance(0.5) ? ITCH::Side::BUY : ITCH::Side::SELL);
+        writer.put32(shares());
+        writer.putBytes(stockName(locate).data(), 8);
+        writer.put32(price);
+        writer.put64(nextMatch++);
+        writer.end<ITCH::TradeMessageType>();
+        ++messages;
+        printed(s, nextMatch - 1);
+    }
+
+    // one cross per symbol at its mid, a tenth of them match nothing
+    void crosses(char crossType) {
+        for (uint32_t locate = 1; locate <= config.symbols; ++locate) {
+            Symbol & s = symbols[locate - 1];
+            uint64_t const crossed = rng.chance(0.1) ? 0 : rng.between(1, 100) * 100;
+            writer.begin<ITCH::CrossTradeMessageType>(locate, timestamp);
+            writer.put64(crossed);
+            writer.putBytes(stockName(locate).data(), 8);
+            writer.put32(s.mid);
+            writer.put64(nextMatch++);
+            writer.put8(crossType);
+            writer.end<ITCH::CrossTradeMessageType>();
+            ++messages;
+            if (crossed) printed(s, nextMatch - 1);
+        }
+    }
+
+    void printed(Symbol & s, uint64_t match) {
+        if (config.broken > 0 && rng.chance(config.broken)) s.toBreak.push_back(match);
+    }
+
+    void brokenTrade(uint32_t locate, uint64_t match) {
+        writer.begin<ITCH::BrokenTradeMessageType>(locate, timestamp);
+        writer.put64(match);
+        writer.end<ITCH::BrokenTradeMessageType>();
+        ++messages;
+    }
+
+    void systemEvent(uint64_t ts, char eventCode) {
+        writer.begin<ITCH::SystemEventMessageType>(0, ts);
+        writer.put8(eventCode);
+        writer.end<ITCH::SystemEventMessageType>();
+        ++messages;
+    }
+
+    void stockDirectory(uint64_t ts, uint32_t locate) {
+        std::string const stock = stockName(locate);
+        writer.begin<ITCH::StockDirectoryMessageType>(locate, ts);
+        writer.putBytes(stock.data(), 8);
+        writer.put8('Q');           // market category
+        writer.put8('N');           // financial status
+        writer.put32(100);          // round lot size
+        writer.put8('N');           // round lots only
+        writer.put8('C');           // issue classification
+        writer.putBytes("Z ", 2);   // issue sub type
+        writer.put8('P');           // authenticity
+        writer.put8('N');           // short sale threshold
+        writer.put8(' ');           // IPO flag
+        writer.put8('1');           // LULD reference price tier
+        writer.put8('N');           // ETP flag
+        writer.put32(0);            // ETP leverage factor
+        writer.put8('N');           // inverse
+        writer.end<ITCH::StockDirectoryMessageType>();
+        ++messages;
+    }
+
+    Config const &          config;
+    Writer &                writer;
+    Rng                     rng;
+    std::vector<Symbol>     symbols;
+    double                  cumulative[4];
+    uint64_t                nextReference;
+    uint64_t                nextMatch;
+    uint64_t                timestamp;
+    uint64_t                step;
+    uint64_t                messages;
+};
+
+bool parseMix(char const * arg, Mix & mix) {
+    double w[5];
+    if (std::sscanf(arg, "%lf,%lf,%lf,%lf,%lf", &w[0], &w[1], &w[2], &w[3], &w[4]) != 5) return false;
+    if (std::any_of(w, w + 5, [](double v) { return v < 0; }) || w[0] <= 0) return false;
+    mix = Mix{w[0], w[1], w[2], w[3], w[4]};
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    Config config;
+    char const * outputFilename = nullptr;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        if (!std::strcmp(argv[i], "--symbols") && i + 1 < argc) {
+            config.symbols = std::strtoul(argv[++i], nullptr, 10);
+            ok = config.symbols > 0 && config.symbols < 65536;
+        } else if (!std::strcmp(argv[i], "--orders-per-symbol") && i + 1 < argc) {
+            config.ordersPerSymbol = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--mix") && i + 1 < argc) {
+            ok = parseMix(argv[++i], config.mix);
+        } else if (!std::strcmp(argv[i], "--skew") && i + 1 < argc) {
+            config.skew = std::strtod(argv[++i], nullptr);
+            ok = config.skew > 0 && config.skew <= 1;
+        } else if (!std::strcmp(argv[i], "--trades") && i + 1 < argc) {
+            config.trades = std::strtod(argv[++i], nullptr);
+            ok = config.trades >= 0 && config.trades <= 1;
+        } else if (!std::strcmp(argv[i], "--broken") && i + 1 < argc) {
+            config.broken = std::strtod(argv[++i], nullptr);
+            ok = config.broken >= 0 && config.broken <= 1;
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            // an unknown option or one missing its value, never a file to overwrite
+            ok = false;
+        } else if (!outputFilename) {
+            outputFilename = argv[i];
+        } else {
+            ok = false;
+        }
+    }
+
+    if (!ok || !outputFilename) {
+        std::cout << "Usage: " << argv[0] << " [--symbols N] [--orders-per-symbol N] [--mix add,delete,replace,execute,cancel] [--skew P] [--trades P] [--broken P] [--seed N] output_filename" << std::endl;
+        std::cout << "\n" << "where" << '\n'
+            << "\t" << "--symbols: stock locates 1..N (default 100, below 65536)" << '\n'
+            << "\t" << "--orders-per-symbol: adds per symbol on average, the stream ends after symbols * this many adds (default 10000)" << '\n'
+            << "\t" << "--mix: relative weights of the order flow (default the 12302019.NASDAQ_ITCH50 counts, ~45/43/8/2/1)" << '\n'
+            << "\t" << "--skew: 0 < P <= 1, chance an order rests at each tick on its way out from the touch, higher keeps levels nearer (default 0.3)" << '\n'
+            << "\t" << "--trades: chance of a non-displayed trade (P) after each execution, above 0 also adds opening and closing crosses (Q) (default 0)" << '\n'
+            << "\t" << "--broken: chance each print is broken (B) later in the day (default 0)" << '\n'
+            << "\t" << "--seed: the same seed and options always give the same file (default 1)"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    FILE * const out = std::fopen(outputFilename, "wb");
+    if (!out) {
+        std::perror(outputFilename);
+        return EXIT_FAILURE;
+    }
+    uint64_t messages, bytes;
+    {
+        Writer writer(out);
+        Generator generator(config, writer);
+        generator.run();
+        writer.flush();
+        messages = generator.messageCount();
+        bytes = writer.bytesWritten();
+    }
+    std::fclose(out);
+    std::cout << "wrote " << messages << " messages (" << bytes << " bytes) to " << outputFilename << std::endl;
+}
@@ -0,0 +1,76 @@
+// Builds the time index of an ITCH file (time_index.hpp) and looks up where replay of a timestamp starts
+// the index is kept next to the file and rebuilt when missing or out of date, nothing else reads it
+// usage: ./itch-index [options] itch_filename [timestamp...]
+#include "time_index.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include <cstdio>                   // perror
+#include <sys/stat.h>               // stat
+
+int main(int argc, char ** argv) {
+    TimeIndex::Interval interval;
+    bool rebuild = false;
+    char const * itchFilename = nullptr;
+    std::vector<uint64_t> timestamps;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        if (!std::strcmp(argv[i], "--every") && i + 1 < argc) {
+            interval.messages = std::strtoull(argv[++i], nullptr, 10);
+            ok = interval.messages > 0;
+        } else if (!std::strcmp(argv[i], "--interval-ms") && i + 1 < argc) {
+            interval.nanoseconds = std::strtoull(argv[++i], nullptr, 10) * 1000000;
+        } else if (!std::strcmp(argv[i], "--rebuild")) {
+            rebuild = true;
+        } else if (!itchFilename) {
+            itchFilename = argv[i];
+        } else {
+            timestamps.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+
+    if (!ok || !itchFilename) {
+        std::cout << "Usage: " << argv[0] << " [--every N] [--interval-ms MS] [--rebuild] itch_filename [timestamp...]" << std::endl;
+        std::cout << "\n" << "where" << '\n'
+            << "\t" << "--every: checkpoint at least every N messages (default 1048576)" << '\n'
+            << "\t" << "--interval-ms: and at the first message of every MS milliseconds of market time, 0 for none (default 1000)" << '\n'
+            << "\t" << "--rebuild: rebuild <itch_filename>.idx even if it is up to date" << '\n'
+            << "\t" << "timestamp: print the checkpoint replay of this timestamp starts from, as timestamp,offset,messages"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    struct stat st;
+    if (stat(itchFilename, &st) == -1) {
+        std::perror(itchFilename);
+        return EXIT_FAILURE;
+    }
+    std::string const indexFilename = TimeIndex::filenameFor(itchFilename);
+    try {
+        std::optional<TimeIndex> index;
+        if (!rebuild) {
+            try {
+                index.emplace(indexFilename.c_str(), st.st_size);
+            } catch (std::invalid_argument const &) {}
+        }
+        if (!index) {
+            auto const t1 = std::chrono::steady_clock::now();
+            index = TimeIndex::build(itchFilename, interval);
+            index->write(indexFilename.c_str());
+            auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t1).count();
+            std::cerr << "indexed " << itchFilename << " (" << index->checkpoints().size() << " checkpoints) in " << elapsed << " milliseconds" << std::endl;
+        }
+        for (uint64_t const timestamp : timestamps) {
+            TimeCheckpoint const & c = index->seek(timestamp);
+            std::cout << c.timestamp << ',' << c.offset << ',' << c.messages << std::endl;
+        }
+    } catch (std::exception const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
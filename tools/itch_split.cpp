@@ -0,0 +1,323 @@
+// Splits an ITCH file into BinaryFILE shards by stock locate in one pass
+// each shard is a valid file on its own: it starts with the system messages seen before it was opened,
+// gets every later one, and keeps the original order of everything it holds
+// usage: ./itch-split [options] itch_filename
+#include "itch_common.hpp"
+#include "itch_reader.hpp"
+#include "itch_views.hpp"
+#include "compressed_reader.hpp"
+#include "symbol_filter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>                  // open, O_DIRECT
+#include <unistd.h>                 // write, close
+#include <sys/resource.h>           // setrlimit
+
+namespace {
+
+// O_DIRECT transfers must be aligned in memory, offset and size
+constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+// some filesystems, e.g. tmpfs, refuse O_DIRECT, those shards are written through the page cache
+int openShard(std::string const & filename, bool & direct) {
+    int const flags = O_WRONLY | O_CREAT | O_TRUNC;
+    if (direct) {
+        int const fd = open(filename.c_str(), flags | O_DIRECT, 0644);
+        if (fd != -1 || errno != EINVAL) return fd;
+        direct = false;
+    }
+    return open(filename.c_str(), flags, 0644);
+}
+
+// one output file, written a large buffer at a time
+// with O_DIRECT only whole blocks are written until the end, the tail is written once it is turned off
+class Shard {
+public:
+    Shard(std::string const & _filename, size_t bufferBytes, bool direct) :
+        filename(_filename),
+        directIO(direct),
+        fd(openShard(_filename, directIO)),
+        capacity(std::max(bufferBytes, 2 * DIRECT_ALIGNMENT) / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT),
+        buffer(static_cast<char *>(std::aligned_alloc(DIRECT_ALIGNMENT, capacity))),
+        used(0),
+        written(0),
+        messages(0) {
+        if (fd == -1) {
+            std::free(buffer);
+            throw std::invalid_argument(std::string("Failed to open file: ") + _filename + " (" + std::strerror(errno) + ")");
+        }
+        if (!buffer) {
+            close(fd);
+            throw std::bad_alloc();
+        }
+    }
+
+    Shard(Shard const &)                = delete;
+    Shard & operator=(Shard const &)    = delete;
+
+    ~Shard() {
+        close(fd);
+        std::free(buffer);
+    }
+
+    void append(char const * messageData) {
+        size_t const bytes = ITCH::messageHeaderLength + ITCH::Parser::getDataMessageLength(messageData);
+        if (used + bytes > capacity) {
+            flush(false);
+            // O_DIRECT keeps the partial block, a length past what is left is a corrupt message
+            if (used + bytes > capacity) throw std::runtime_error(std::string("Message of ") + std::to_string(bytes) + " bytes does not fit the buffer of " + filename);
+        }
+        std::memcpy(buffer + used, messageData, bytes);
+        used += bytes;
+        ++messages;
+    }
+
+    // everything buffered, then the file is complete
+    void finish() {
+        if (directIO) {
+            flush(false);
+            // the tail is not a whole block, write it through the page cache
+            int const flags = fcntl(fd, F_GETFL);
+            if (flags == -1 || fcntl(fd, F_SETFL, flags & ~O_DIRECT) == -1) fail();
+            directIO = false;
+        }
+        flush(true);
+    }
+
+    uint64_t bytes() const { return written + used; }
+    uint64_t messageCount() const { return messages; }
+    bool direct() const { return directIO; }
+
+private:
+    void flush(bool all) {
+        size_t const bytes = directIO && !all ? used / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT : used;
+        size_t done = 0;
+        while (done < bytes) {
+            ssize_t const n = write(fd, buffer + done, bytes - done);
+            if (n <= 0) {
+                if (n == -1 && errno == EINTR) continue;
+                fail();
+            }
+            done += n;
+        }
+        written += bytes;
+        used -= bytes;
+        std::memmove(buffer, buffer + bytes, used);
+    }
+
+    [[noreturn]] void fail() const {
+        throw std::runtime_error(std::string("Failed to write file: ") + filename + " (" + std::strerror(errno) + ")");
+    }
+
+    std::string const   filename;
+    bool                directIO;
+    int const           fd;
+    size_t const        capacity;
+    char * const        buffer;
+    size_t              used;
+    uint64_t            written;
+    uint64_t            messages;
+};
+
+struct Options {
+    size_t          buckets     = 0;            // shard by locate % buckets, or one shard per locate if 0
+    size_t          bufferBytes = 0;            // per shard, 0 for the default of the mode
+    bool            direct      = false;
+    std::string     out         = ".";
+    std::vector<std::string> symbols;           // every locate if empty
+};
+
+// routes each message to its shard, opening shards as their first message arrives
+// locate 0 (system events) goes to every shard, and with buckets so does the stock directory
+// a shard opened late is first given the broadcast messages it missed, so it still starts at the start of day
+class Splitter {
+public:
+    Splitter(Options const & _options, std::string const & _prefix) :
+        options(_options),
+        prefix(_prefix),
+        shards(options.buckets ? options.buckets : 1 << 16),
+        warned(false) {}
+
+    void handle(char const * messageData) {
+        ITCH::MessageView const view(messageData);
+        uint16_t const stockLocate = view.stockLocate();
+        bool const directory = view.messageType() == ITCH::StockDirectoryMessageType;
+        if (!stockLocate || (directory && options.buckets)) {
+            broadcast(messageData);
+            // a bucket is still opened by the first directory message of one of its locates
+            if (!stockLocate) return;
+        }
+        size_t const index = options.buckets ? stockLocate % options.buckets : stockLocate;
+        std::unique_ptr<Shard> & shard = shards[index];
+        if (!shard) {
+            open(shard, index, directory ? ITCH::StockDirectoryView(messageData).stock() : nullptr);
+            // with buckets its directory message went out with the missed broadcasts
+            if (directory && options.buckets) return;
+        } else if (directory && options.buckets) {
+            return;
+        }
+        shard->append(messageData);
+    }
+
+    void finish() {
+        for (Shard * shard : open_) shard->finish();
+    }
+
+    std::vector<Shard *> const & opened() const { return open_; }
+
+private:
+    void broadcast(char const * messageData) {
+        size_t const bytes = ITCH::messageHeaderLength + ITCH::Parser::getDataMessageLength(messageData);
+        missed.insert(missed.end(), messageData, messageData + bytes);
+        for (Shard * shard : open_) shard->append(messageData);
+    }
+
+    void open(std::unique_ptr<Shard> & shard, size_t index, char const * stock) {
+        std::string filename = prefix + ".";
+        if (options.buckets) {
+            filename += "bucket" + std::to_string(index);
+        } else if (stock) {
+            // space padded, e.g. "BRK A   " becomes BRK_A
+            std::string ticker(stock, 8);
+            ticker.erase(ticker.find_last_not_of(' ') + 1);
+            std::replace(ticker.begin(), ticker.end(), ' ', '_');
+            std::replace(ticker.begin(), ticker.end(), '/', '_');
+            filename += ticker;
+        } else {
+            filename += "locate" + std::to_string(index);
+        }
+        shard = std::make_unique<Shard>(filename, options.bufferBytes, options.direct);
+        if (options.direct && !shard->direct() && !warned) {
+            std::cerr << "O_DIRECT not supported in " << options.out << ", writing through the page cache" << std::endl;
+            warned = true;
+        }
+        for (size_t offset = 0; offset < missed.size(); ) {
+            char const * const messageData = missed.data() + offset;
+            shard->append(messageData);
+            offset += ITCH::messageHeaderLength + ITCH::Parser::getDataMessageLength(messageData);
+        }
+        open_.push_back(shard.get());
+    }
+
+    Options const &                     options;
+    std::string const                   prefix;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Shard *>                open_;      // in the order they were opened
+    std::vector<char>                   missed;     // every broadcast message so far
+    bool                                warned;
+};
+
+template <typename Reader>
+uint64_t split(Reader & reader, Splitter & splitter, SymbolFilter * symbols) {
+    uint64_t messages = 0;
+    char const * messageData;
+    while ((messageData = reader.nextMessage())) {
+        ++messages;
+        if (symbols && !symbols->pass(messageData)) continue;
+        splitter.handle(messageData);
+    }
+    return messages;
+}
+
+// a shard per locate is a file descriptor per locate, ~8,000 on a full day
+void raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    Options options;
+    char const * itchFilename = nullptr;
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        if (!std::strcmp(argv[i], "--buckets") && i + 1 < argc) {
+            options.buckets = std::strtoul(argv[++i], nullptr, 10);
+            ok = options.buckets > 0 && options.buckets <= 1 << 16;
+        } else if (!std::strcmp(argv[i], "--buffer-kb") && i + 1 < argc) {
+            options.bufferBytes = std::strtoull(argv[++i], nullptr, 10) << 10;
+            ok = options.bufferBytes > 0;
+        } else if (!std::strcmp(argv[i], "--direct")) {
+            options.direct = true;
+        } else if (!std::strcmp(argv[i], "--out") && i + 1 < argc) {
+            options.out = argv[++i];
+        } else if (!std::strcmp(argv[i], "--symbols") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::parse(argv[++i]);
+            options.symbols.insert(options.symbols.end(), listed.begin(), listed.end());
+        } else if (!std::strcmp(argv[i], "--symbols-file") && i + 1 < argc) {
+            std::vector<std::string> const listed = SymbolFilter::load(argv[++i]);
+            options.symbols.insert(options.symbols.end(), listed.begin(), listed.end());
+        } else if (!itchFilename) {
+            itchFilename = argv[i];
+        } else {
+            ok = false;
+        }
+    }
+
+    if (!ok || !itchFilename) {
+        std::cout << "Usage: " << argv[0] << " [--buckets N] [--buffer-kb KB] [--direct] [--out directory] [--symbols TICKER,...] [--symbols-file filename] itch_filename" << std::endl;
+        std::cout << "\n" << "where" << '\n'
+            << "\t" << "itch_filename: a NasdaqTotalViewITCH file in BinaryFILE format, optionally gzip or zstd compressed" << '\n'
+            << "\t" << "--buckets: write N shards <out>/<itch_filename>.bucket<locate % N> (default, one shard <out>/<itch_filename>.<TICKER> per locate)" << '\n'
+            << "\t" << "--buffer-kb: write buffer per shard (default 16 per locate, 1024 with --buckets)" << '\n'
+            << "\t" << "--direct: write with O_DIRECT, bypassing the page cache" << '\n'
+            << "\t" << "--out: directory for the shards (default .)" << '\n'
+            << "\t" << "--symbols: only write the shards of these tickers" << '\n'
+            << "\t" << "--symbols-file: as --symbols, one ticker per line"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        std::string basename = itchFilename;
+        size_t const slash = basename.find_last_of('/');
+        if (slash != std::string::npos) basename.erase(0, slash + 1);
+        if (!options.buckets) raiseFileLimit();
+        // a full day has ~8000 locates, so per locate shards get small buffers
+        if (!options.bufferBytes) options.bufferBytes = options.buckets ? 1 << 20 : 16 << 10;
+
+        std::unique_ptr<SymbolFilter> symbols;
+        if (!options.symbols.empty()) symbols = std::make_unique<SymbolFilter>(options.symbols);
+        Splitter splitter(options, options.out + "/" + basename);
+
+        auto const t1 = std::chrono::steady_clock::now();
+        uint64_t messages;
+        if (ITCH::CompressedReader::detect(itchFilename) != ITCH::CompressedReader::Format::RAW) {
+            ITCH::CompressedReader reader(itchFilename);
+            messages = split(reader, splitter, symbols.get());
+        } else {
+            ITCH::Reader reader(itchFilename, 4 << 20);
+            messages = split(reader, splitter, symbols.get());
+        }
+        splitter.finish();
+        double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+        uint64_t written = 0, bytes = 0;
+        for (Shard const * shard : splitter.opened()) {
+            written += shard->messageCount();
+            bytes += shard->bytes();
+        }
+        std::cout << "split " << messages << " messages into " << splitter.opened().size() << " shards ("
+            << written << " messages, " << bytes << " bytes) in "
+            << seconds * 1000 << " milliseconds";
+        if (seconds > 0) std::cout << " (" << messages / seconds / 1000000 << "M messages/s)";
+        std::cout << std::endl;
+        if (symbols) std::cerr << *symbols << std::endl;
+    } catch (std::exception const & e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}